@@ -63,7 +63,15 @@ enum icd_scan_request_flags {
   /** passively receive scan results when other apps are requesting them;
    * don't start a network scan because of this application; not yet
    * implemented */
-  ICD_SCAN_REQUEST_PASSIVE = 2
+  ICD_SCAN_REQUEST_PASSIVE = 2,
+  /** flag to be or'ed with the above values; receive scan results batched
+   * in #ICD_DBUS_API_SCAN_RESULTS_SIG signals instead of one
+   * #ICD_DBUS_API_SCAN_SIG signal per network */
+  ICD_SCAN_REQUEST_BATCHED = 0x100,
+  /** flag to be or'ed with the above values; the results of a scan that
+   * completed a few seconds ago are good enough and no new scan is started
+   * unless aggressive scanning is configured */
+  ICD_SCAN_REQUEST_CACHED = 0x200
 };
 
 /** Initiate a scan.
@@ -73,7 +81,19 @@ enum icd_scan_request_flags {
  * DBUS_TYPE_UINT32               passively listen/actively request scan
  *                                results, see #icd_scan_request_flags
  * array of DBUS_TYPE_STRING      network types to scan; no array or empty
- *                                array to scan all network types</pre>
+ *                                array to scan all network types
+ * DBUS_TYPE_INT32                optional filter: minimum signal level
+ * DBUS_TYPE_UINT32               network attributes that must be set
+ * DBUS_TYPE_UINT32               network attributes that must not be set
+ * DBUS_TYPE_STRING               service type or empty string for any
+ * DBUS_TYPE_BOOLEAN              TRUE to receive only networks with a
+ *                                saved IAP
+ * DBUS_TYPE_ARRAY (BYTE)         optional network id; if given, only this
+ *                                network is searched for by network modules
+ *                                supporting it</pre>
+ * If the optional filter arguments are given, the network types array must
+ * also be present and only scan results passing the filter are sent.
+ *
  * Return arguments:
  * <pre>
  * array of DBUS_TYPE_STRING      network types which are going to be scanned</pre>
@@ -132,6 +152,74 @@ enum icd_scan_status {
  */
 #define ICD_DBUS_API_SCAN_SIG     "scan_result_sig"
 
+/** Batched scan results signal, sent instead of #ICD_DBUS_API_SCAN_SIG to
+ * applications that requested #ICD_SCAN_REQUEST_BATCHED. Scan results are
+ * collected until the scan round completes, a short flush window expires or
+ * the signal grows too large.
+ *
+ * Arguments:
+ *<pre>
+ * DBUS_TYPE_ARRAY (
+ *   DBUS_TYPE_UINT32              status, see #icd_scan_status
+ *   DBUS_TYPE_UINT32              timestamp when last seen
+ *   DBUS_TYPE_STRING              service type
+ *   DBUS_TYPE_STRING              service name
+ *   DBUS_TYPE_UINT32              service attributes, see @ref srv_provider_api
+ *   DBUS_TYPE_STRING              service id
+ *   DBUS_TYPE_INT32               service priority within a service type
+ *   DBUS_TYPE_STRING              network type
+ *   DBUS_TYPE_STRING              network name
+ *   DBUS_TYPE_UINT32              network attributes, see @ref network_module_api
+ *   DBUS_TYPE_ARRAY (BYTE)        network id
+ *   DBUS_TYPE_INT32               network priority for different network types
+ *   DBUS_TYPE_INT32               signal strength/quality, 0 (none) - 10 (good)
+ *   DBUS_TYPE_STRING              station id, e.g. MAC address or similar id
+ *   DBUS_TYPE_INT32               signal value in dB
+ * )</pre>
+ */
+#define ICD_DBUS_API_SCAN_RESULTS_SIG     "scan_results_sig"
+
+/** Request the scan cache changes since a generation, so that an application
+ * can resync its list of networks without a full replay. Each change to any
+ * scan cache increments the generation. Generations are only valid within
+ * the epoch they were returned with; the epoch changes when ICd2 restarts.
+ * Added and updated networks are returned with #ICD_SCAN_UPDATE and removed
+ * ones with #ICD_SCAN_EXPIRE; if the epoch does not match or ICd2 no longer
+ * remembers all removals since the given generation, the whole scan cache is
+ * returned with #ICD_SCAN_NEW instead.
+ *
+ * Arguments:
+ *<pre>
+ * DBUS_TYPE_UINT32               epoch returned with the generation, 0 if none
+ * DBUS_TYPE_UINT32               generation the application is up to date
+ *                                with, 0 for the whole scan cache</pre>
+ * Return arguments:
+ * <pre>
+ * DBUS_TYPE_ARRAY (...)          scan results as in
+ *                                #ICD_DBUS_API_SCAN_RESULTS_SIG
+ * DBUS_TYPE_UINT32               current epoch
+ * DBUS_TYPE_UINT32               current generation
+ * DBUS_TYPE_BOOLEAN              TRUE if only changes were returned, FALSE if
+ *                                the whole scan cache was returned</pre>
+ */
+#define ICD_DBUS_API_SCAN_CHANGES_REQ     "scan_changes_req"
+
+/** Request the networks currently in the scan cache without starting a scan.
+ * The networks are returned with #ICD_SCAN_NEW.
+ *
+ * Arguments:
+ *<pre>
+ * DBUS_TYPE_STRING               optional network type or empty string for
+ *                                all network types
+ * DBUS_TYPE_UINT32               maximum seconds since the network was last
+ *                                seen or 0 for any age</pre>
+ * Return arguments:
+ * <pre>
+ * DBUS_TYPE_ARRAY (...)          scan results as in
+ *                                #ICD_DBUS_API_SCAN_RESULTS_SIG</pre>
+ */
+#define ICD_DBUS_API_SCAN_CACHE_GET_REQ   "scan_cache_get_req"
+
 /** flags for #ICD_DBUS_API_CONNECT_REQ */
 enum icd_connection_flags {
   /** no flags requested */
@@ -320,6 +408,32 @@ enum icd_connection_state {
  */
 #define ICD_DBUS_API_STATE_SIG "state_sig"
 
+/** Request the state of all connections and network searches in one reply
+ * instead of #ICD_DBUS_API_STATE_SIG signals.
+ *
+ * Arguments:
+ *<pre>
+ * none</pre>
+ *
+ * Return arguments:
+ *<pre>
+ * DBUS_TYPE_ARRAY (
+ *   DBUS_TYPE_STRING              service type or empty string
+ *   DBUS_TYPE_UINT32              service attributes, see @ref srv_provider_api
+ *   DBUS_TYPE_STRING              service id or empty string
+ *   DBUS_TYPE_STRING              network type or empty string
+ *   DBUS_TYPE_UINT32              network attributes, see @ref network_module_api
+ *   DBUS_TYPE_ARRAY (BYTE)        network id or empty string
+ *   DBUS_TYPE_STRING              error that occured; empty string on success
+ *   DBUS_TYPE_UINT32              state of the network connection, see
+ *                                 #icd_connection_state
+ *   DBUS_TYPE_BOOLEAN             TRUE if the service provider module has
+ *                                 enabled limited connectivity
+ * )
+ * DBUS_TYPE_ARRAY (STRING)      network types for which search is done</pre>
+ */
+#define ICD_DBUS_API_STATE_SNAPSHOT_REQ "state_snapshot_req"
+
 /** Request specific connection statistics.
  *
  * Arguments:
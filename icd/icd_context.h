@@ -14,6 +14,8 @@ struct icd_context {
 
   GSList *nw_module_list;
   GHashTable *type_to_module;
+  GHashTable *nw_type_registry;
+  GPtrArray *nw_type_ids;
 
   GSList *srv_module_list;
   GHashTable *srv_type_to_srv_module;
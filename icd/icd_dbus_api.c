@@ -10,6 +10,7 @@
 #include "icd_request.h"
 #include "icd_name_owner.h"
 #include "icd_gconf.h"
+#include "icd_dbus_dispatch.h"
 
 struct icd_dbus_api_addrinfo_data {
   DBusMessage *message;
@@ -43,10 +44,68 @@ struct icd_dbus_api_statistics_data {
   guint tx_bytes;
 };
 
+/** time in milliseconds batched scan results are collected before sending */
+#define ICD_DBUS_API_SCAN_BATCH_WINDOW   500
+
+/** maximum number of scan results in one #ICD_DBUS_API_SCAN_RESULTS_SIG */
+#define ICD_DBUS_API_SCAN_BATCH_MAX   64
+
+/** number of unbatched scan listeners from which on one
+ * #ICD_DBUS_API_SCAN_SIG is built per scan result and copied to each
+ * listener */
+#define ICD_DBUS_API_SCAN_FANOUT_MIN   4
+
+/** D-Bus signature of one scan result in #ICD_DBUS_API_SCAN_RESULTS_SIG */
+#define ICD_DBUS_API_SCAN_RESULT_SIGNATURE   "(uussusissuayiisi)"
+
+/** D-Bus app receiving scan results */
+struct icd_dbus_api_scan_listener {
+  /** D-Bus sender */
+  gchar *dbus_dest;
+
+  /** scan request flags, see #icd_scan_request_flags */
+  guint flags;
+
+  /** scan result filter requested by the app, if filtered is set */
+  struct icd_scan_filter filter;
+
+  /** whether the app requested scan results to be filtered */
+  gboolean filtered;
+
+  /** pending #ICD_DBUS_API_SCAN_RESULTS_SIG or NULL */
+  DBusMessage *batch;
+
+  /** iterator for the signal arguments */
+  DBusMessageIter batch_iter;
+
+  /** iterator for the array of scan results */
+  DBusMessageIter batch_array;
+
+  /** number of scan results in the pending signal */
+  guint batch_count;
+
+  /** batch flush timeout id */
+  guint batch_timeout;
+};
+
 /** ICd2 D-Bus API data structure */
 struct icd_dbus_api_listeners {
-  /** dbus apps receiving scan results */
-  GSList *scan_listeners;
+  /** #icd_dbus_api_scan_listener dbus apps receiving scan results by their
+   *  D-Bus id */
+  GHashTable *scan_listeners;
+
+  /** number of scan listeners that did not request batched scan results */
+  guint scan_unbatched;
+
+  /** #ICD_DBUS_API_SCAN_SIG without destination for the latest scan result
+   *  by its service provider, NULL for the network itself */
+  GHashTable *scan_templates;
+
+  /** scan listener notification serial of the templates */
+  guint scan_template_serial;
+
+  /** scan status of the templates */
+  enum icd_scan_status scan_template_status;
 };
 
 /** Helper structure for starting a scan */
@@ -55,7 +114,7 @@ struct icd_dbus_api_scan_helper {
   DBusMessageIter *reply_str_iter;
 
   /** scan listener */
-  gchar *dbus_dest;
+  struct icd_dbus_api_scan_listener *listener;
 
   /** passive/active scan type */
   guint scan_type;
@@ -87,6 +146,7 @@ struct icd_dbus_api_foreach_data {
 };
 
 static DBusHandlerResult icd_dbus_api_state_req(DBusConnection *conn, DBusMessage *msg, void *user_data);
+static DBusHandlerResult icd_dbus_api_state_snapshot_req(DBusConnection *conn, DBusMessage *msg, void *user_data);
 
 static gboolean
 icd_dbus_api_foreach_iap_req(DBusMessage *message,
@@ -758,29 +818,35 @@ icd_dbus_api_listeners_get(void)
   static struct icd_dbus_api_listeners *listeners = NULL;
 
   if (!listeners)
-     listeners = g_new0(struct icd_dbus_api_listeners, 1);
+  {
+    listeners = g_new0(struct icd_dbus_api_listeners, 1);
+    listeners->scan_listeners = g_hash_table_new(g_str_hash, g_str_equal);
+    listeners->scan_templates =
+        g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                              (GDestroyNotify)dbus_message_unref);
+  }
 
    return &listeners;
 }
 
 /**
- * @brief Receive scan results and send them via D-Bus
+ * @brief Append the scan result arguments to a D-Bus message
  *
+ * @param iter the message iterator to append to
  * @param status status of this network
- * @param srv_provider service provider entry; guaranteed to exist only for the
- * lifetime of this callback function
- * @param cache_entry scan results; guaranteed to exist only for the lifetime of
- * this callback function
- * @param user_data D-Bus app that requested the scan
+ * @param srv_provider service provider entry or NULL
+ * @param cache_entry scan results
+ *
+ * @return TRUE on success, FALSE if out of memory
  *
  */
-static void
-icd_dbus_api_scan_result(enum icd_scan_status status,
-                         const struct icd_scan_srv_provider *srv_provider,
-                         const struct icd_scan_cache *cache_entry,
-                         gpointer user_data)
+static gboolean
+icd_dbus_api_scan_append_args(DBusMessageIter *iter,
+                              enum icd_scan_status status,
+                              const struct icd_scan_srv_provider *srv_provider,
+                              const struct icd_scan_cache *cache_entry)
 {
-  DBusMessage *message;
+  DBusMessageIter sub;
   const gchar **service_id;
   const gchar *network_id;
   const gchar *const *service_type;
@@ -790,28 +856,17 @@ icd_dbus_api_scan_result(enum icd_scan_status status,
   const gchar **station_id;
   const dbus_uint32_t *service_attrs;
   const dbus_int32_t *service_priority;
+  dbus_uint32_t scan_status = status;
+  dbus_uint32_t network_attrs = cache_entry->network_attrs;
   dbus_uint32_t uzero = 0;
   dbus_int32_t izero = 0;
   const gchar *empty = "";
 
-  message = dbus_message_new_signal(ICD_DBUS_API_PATH,
-                                    ICD_DBUS_API_INTERFACE,
-                                    ICD_DBUS_API_SCAN_SIG);
-
-  if (!message)
-  {
-    ILOG_CRIT("dbus api out of memory when creating scan signal");
-    return;
-  }
-
-  if (!dbus_message_set_destination(message, (const char *)user_data))
-  {
-    ILOG_CRIT("dbus api out of memory when setting destination");
-    goto out;
-  }
-
   network_id = cache_entry->network_id ? cache_entry->network_id : empty;
 
+  if (cache_entry->stale)
+    network_attrs |= ICD_NW_ATTR_STALE;
+
   if (srv_provider)
   {
     service_type = srv_provider->service_type ?
@@ -839,34 +894,311 @@ icd_dbus_api_scan_result(enum icd_scan_status status,
   station_id = cache_entry->station_id ?
         (const gchar**)&cache_entry->station_id : &empty;
 
-  if (dbus_message_append_args(message,
-                               DBUS_TYPE_UINT32,  &status,
-                               DBUS_TYPE_UINT32, cache_entry,
-                               DBUS_TYPE_STRING, service_type,
-                               DBUS_TYPE_STRING, service_name,
-                               DBUS_TYPE_UINT32, service_attrs,
-                               DBUS_TYPE_STRING, service_id,
-                               DBUS_TYPE_INT32, service_priority,
-                               DBUS_TYPE_STRING, network_type,
-                               DBUS_TYPE_STRING, network_name,
-                               DBUS_TYPE_UINT32, &cache_entry->network_attrs,
-                               DBUS_TYPE_ARRAY, DBUS_TYPE_BYTE,
-                               &network_id, strlen(network_id) + 1,
-                               DBUS_TYPE_INT32, &cache_entry->network_priority,
-                               DBUS_TYPE_INT32, &cache_entry->signal,
-                               DBUS_TYPE_STRING, station_id,
-                               DBUS_TYPE_INT32, &cache_entry->dB,
-                               DBUS_TYPE_INVALID))
+  return
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_UINT32, &scan_status) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_UINT32,
+                                     &cache_entry->last_seen) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, service_type) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, service_name) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_UINT32, service_attrs) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, service_id) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_INT32, service_priority) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, network_type) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, network_name) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_UINT32,
+                                     &network_attrs) &&
+      dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY,
+                                       DBUS_TYPE_BYTE_AS_STRING, &sub) &&
+      dbus_message_iter_append_fixed_array(&sub, DBUS_TYPE_BYTE, &network_id,
+                                           strlen(network_id) + 1) &&
+      dbus_message_iter_close_container(iter, &sub) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_INT32,
+                                     &cache_entry->network_priority) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_INT32,
+                                     &cache_entry->signal) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_STRING, station_id) &&
+      dbus_message_iter_append_basic(iter, DBUS_TYPE_INT32, &cache_entry->dB);
+}
+
+/**
+ * @brief Send the pending batched scan results signal, if any
+ *
+ * @param listener the D-Bus scan listener
+ *
+ */
+static void
+icd_dbus_api_scan_batch_flush(struct icd_dbus_api_scan_listener *listener)
+{
+  if (listener->batch_timeout)
   {
-    icd_dbus_send_system_msg(message);
+    g_source_remove(listener->batch_timeout);
+    listener->batch_timeout = 0;
+  }
+
+  if (!listener->batch)
+    return;
+
+  if (dbus_message_iter_close_container(&listener->batch_iter,
+                                        &listener->batch_array))
+  {
+    ILOG_DEBUG("dbus api sending %d batched scan results to '%s'",
+               listener->batch_count, listener->dbus_dest);
+    icd_dbus_send_system_msg(listener->batch);
+  }
+  else
+    ILOG_CRIT("dbus api out of memory when closing scan results signal");
+
+  dbus_message_unref(listener->batch);
+  listener->batch = NULL;
+  listener->batch_count = 0;
+}
+
+/**
+ * @brief Batch flush window expired
+ *
+ * @param data the D-Bus scan listener
+ *
+ * @return FALSE to remove the timeout
+ *
+ */
+static gboolean
+icd_dbus_api_scan_batch_timeout(gpointer data)
+{
+  struct icd_dbus_api_scan_listener *listener =
+      (struct icd_dbus_api_scan_listener *)data;
+
+  listener->batch_timeout = 0;
+  icd_dbus_api_scan_batch_flush(listener);
+
+  return FALSE;
+}
+
+/**
+ * @brief Add a scan result to the pending batched scan results signal
+ *
+ * @param listener the D-Bus scan listener
+ * @param status status of this network
+ * @param srv_provider service provider entry or NULL
+ * @param cache_entry scan results
+ *
+ */
+static void
+icd_dbus_api_scan_batch_add(struct icd_dbus_api_scan_listener *listener,
+                            enum icd_scan_status status,
+                            const struct icd_scan_srv_provider *srv_provider,
+                            const struct icd_scan_cache *cache_entry)
+{
+  DBusMessageIter sub;
+
+  if (!listener->batch)
+  {
+    listener->batch = dbus_message_new_signal(ICD_DBUS_API_PATH,
+                                              ICD_DBUS_API_INTERFACE,
+                                              ICD_DBUS_API_SCAN_RESULTS_SIG);
+
+    if (!listener->batch)
+    {
+      ILOG_CRIT("dbus api out of memory when creating scan results signal");
+      return;
+    }
+
+    dbus_message_iter_init_append(listener->batch, &listener->batch_iter);
+
+    if (!dbus_message_set_destination(listener->batch, listener->dbus_dest) ||
+        !dbus_message_iter_open_container(&listener->batch_iter,
+                                          DBUS_TYPE_ARRAY,
+                                          ICD_DBUS_API_SCAN_RESULT_SIGNATURE,
+                                          &listener->batch_array))
+    {
+      ILOG_CRIT("dbus api out of memory when creating scan results signal");
+      dbus_message_unref(listener->batch);
+      listener->batch = NULL;
+      return;
+    }
+
+    listener->batch_timeout = g_timeout_add(ICD_DBUS_API_SCAN_BATCH_WINDOW,
+                                            icd_dbus_api_scan_batch_timeout,
+                                            listener);
+  }
+
+  if (dbus_message_iter_open_container(&listener->batch_array,
+                                       DBUS_TYPE_STRUCT, NULL, &sub) &&
+      icd_dbus_api_scan_append_args(&sub, status, srv_provider, cache_entry) &&
+      dbus_message_iter_close_container(&listener->batch_array, &sub))
+  {
+    listener->batch_count++;
   }
   else
-    ILOG_CRIT("dbus api out of memory when appending scan signal args");
+    ILOG_CRIT("dbus api out of memory when appending scan results");
+
+  if (status == ICD_SCAN_COMPLETE ||
+      listener->batch_count >= ICD_DBUS_API_SCAN_BATCH_MAX)
+  {
+    icd_dbus_api_scan_batch_flush(listener);
+  }
+}
+
+/**
+ * @brief Create a scan signal without destination
+ *
+ * @param status status of this network
+ * @param srv_provider service provider entry or NULL
+ * @param cache_entry scan results
+ *
+ * @return the scan signal or NULL if out of memory
+ *
+ */
+static DBusMessage *
+icd_dbus_api_scan_signal_new(enum icd_scan_status status,
+                             const struct icd_scan_srv_provider *srv_provider,
+                             const struct icd_scan_cache *cache_entry)
+{
+  DBusMessage *message;
+  DBusMessageIter iter;
+
+  message = dbus_message_new_signal(ICD_DBUS_API_PATH,
+                                    ICD_DBUS_API_INTERFACE,
+                                    ICD_DBUS_API_SCAN_SIG);
+
+  if (!message)
+    return NULL;
+
+  dbus_message_iter_init_append(message, &iter);
+
+  if (!icd_dbus_api_scan_append_args(&iter, status, srv_provider, cache_entry))
+  {
+    dbus_message_unref(message);
+    return NULL;
+  }
+
+  return message;
+}
+
+/**
+ * @brief Get the scan signal template for a scan result; a template is built
+ * once per scan listener notification and service provider and reused for
+ * every listener receiving the same result
+ *
+ * @param status status of this network
+ * @param srv_provider service provider entry or NULL
+ * @param cache_entry scan results
+ *
+ * @return the template owned by the dbus api or NULL if out of memory
+ *
+ */
+static DBusMessage *
+icd_dbus_api_scan_template(enum icd_scan_status status,
+                           const struct icd_scan_srv_provider *srv_provider,
+                           const struct icd_scan_cache *cache_entry)
+{
+  struct icd_dbus_api_listeners **listeners = icd_dbus_api_listeners_get();
+  guint serial = icd_scan_listener_notify_serial();
+  DBusMessage *template;
+
+  /* listeners get the network and each of its service providers in turn, so
+     all templates of the notification are kept until the next one */
+  if ((*listeners)->scan_template_serial != serial ||
+      (*listeners)->scan_template_status != status)
+  {
+    g_hash_table_remove_all((*listeners)->scan_templates);
+    (*listeners)->scan_template_serial = serial;
+    (*listeners)->scan_template_status = status;
+  }
+
+  template = (DBusMessage *)g_hash_table_lookup((*listeners)->scan_templates,
+                                                srv_provider);
+
+  if (!template)
+  {
+    template = icd_dbus_api_scan_signal_new(status, srv_provider, cache_entry);
+
+    if (template)
+    {
+      g_hash_table_insert((*listeners)->scan_templates, (gpointer)srv_provider,
+                          template);
+    }
+  }
+
+  return template;
+}
+
+/**
+ * @brief Receive scan results and send them via D-Bus; with many listeners
+ * the signal is serialized once and copied to each of them
+ *
+ * @param status status of this network
+ * @param srv_provider service provider entry; guaranteed to exist only for the
+ * lifetime of this callback function
+ * @param cache_entry scan results; guaranteed to exist only for the lifetime of
+ * this callback function
+ * @param user_data D-Bus app that requested the scan
+ *
+ */
+static void
+icd_dbus_api_scan_result(enum icd_scan_status status,
+                         const struct icd_scan_srv_provider *srv_provider,
+                         const struct icd_scan_cache *cache_entry,
+                         gpointer user_data)
+{
+  struct icd_dbus_api_scan_listener *listener =
+      (struct icd_dbus_api_scan_listener *)user_data;
+  DBusMessage *message;
+
+  if (listener->flags & ICD_SCAN_REQUEST_BATCHED)
+  {
+    icd_dbus_api_scan_batch_add(listener, status, srv_provider, cache_entry);
+    return;
+  }
+
+  if ((*icd_dbus_api_listeners_get())->scan_unbatched >=
+      ICD_DBUS_API_SCAN_FANOUT_MIN)
+  {
+    DBusMessage *template = icd_dbus_api_scan_template(status, srv_provider,
+                                                       cache_entry);
+
+    if (!template)
+      return;
+
+    message = dbus_message_copy(template);
+  }
+  else
+    message = icd_dbus_api_scan_signal_new(status, srv_provider, cache_entry);
+
+  if (!message)
+  {
+    ILOG_CRIT("dbus api out of memory when creating scan signal");
+    return;
+  }
+
+  if (dbus_message_set_destination(message, listener->dbus_dest))
+    icd_dbus_send_system_msg(message);
+  else
+    ILOG_CRIT("dbus api out of memory when setting destination");
 
-out:
   dbus_message_unref(message);
 }
 
+/**
+ * @brief Free a D-Bus scan listener, discarding any pending scan results
+ *
+ * @param listener the D-Bus scan listener
+ *
+ */
+static void
+icd_dbus_api_scan_listener_free(struct icd_dbus_api_scan_listener *listener)
+{
+  if (listener->batch_timeout)
+    g_source_remove(listener->batch_timeout);
+
+  if (listener->batch)
+    dbus_message_unref(listener->batch);
+
+  g_free(listener->filter.service_type);
+  g_free(listener->filter.network_id);
+  g_free(listener->dbus_dest);
+  g_free(listener);
+}
+
 /**
  * @brief Append a the network type of the successfully started network scan to
  * the iterator position
@@ -884,14 +1216,19 @@ static gboolean
 icd_dbus_api_scan_append(gchar *network_type,
                          struct icd_dbus_api_scan_helper *scan_start)
 {
+  guint scope = scan_start->scan_type &
+      ~(ICD_SCAN_REQUEST_BATCHED | ICD_SCAN_REQUEST_CACHED);
   gboolean
-      rv = icd_scan_results_request(network_type, scan_start->scan_type == 1,
-                                    icd_dbus_api_scan_result,
-                                    scan_start->dbus_dest);
+      rv = icd_scan_results_request_filtered(
+            network_type, scope == ICD_SCAN_REQUEST_ACTIVE_SAVED,
+            scan_start->listener->filtered ? &scan_start->listener->filter :
+                                             NULL,
+            (scan_start->scan_type & ICD_SCAN_REQUEST_CACHED) != 0,
+            icd_dbus_api_scan_result, scan_start->listener);
   if (rv)
   {
     ILOG_INFO("dbus api successfully started '%s' scan for '%s'", network_type,
-              scan_start->dbus_dest);
+              scan_start->listener->dbus_dest);
 
     dbus_message_iter_append_basic(scan_start->reply_str_iter,
                                    DBUS_TYPE_STRING, &network_type);
@@ -904,7 +1241,7 @@ static gboolean
 icd_dbus_api_scan_all_types(struct icd_network_module *module,
                             gpointer user_data)
 {
-  if (module->nw.start_search)
+  if (icd_network_api_has_search(module))
   {
     GSList *l;
     struct icd_dbus_api_scan_helper *helper =
@@ -920,18 +1257,72 @@ icd_dbus_api_scan_all_types(struct icd_network_module *module,
   return TRUE;
 }
 
+/**
+ * @brief Read the optional scan result filter arguments of a scan request
+ *
+ * @param iter iterator pointing to the minimum signal level argument
+ * @param filter the filter to fill in
+ *
+ * @return TRUE if the filter arguments were present, FALSE otherwise
+ *
+ */
+static gboolean
+icd_dbus_api_scan_filter_get(DBusMessageIter *iter,
+                             struct icd_scan_filter *filter)
+{
+  dbus_int32_t min_signal;
+  dbus_uint32_t attrs_required, attrs_forbidden;
+  const gchar *service_type;
+  dbus_bool_t saved_only;
+  DBusMessageIter sub;
+  gchar *network_id = NULL;
+  int len = 0;
+
+  if (dbus_message_iter_get_arg_type(iter) != DBUS_TYPE_INT32)
+    return FALSE;
+
+  dbus_message_iter_get_basic(iter, &min_signal);
+  dbus_message_iter_next(iter);
+  dbus_message_iter_get_basic(iter, &attrs_required);
+  dbus_message_iter_next(iter);
+  dbus_message_iter_get_basic(iter, &attrs_forbidden);
+  dbus_message_iter_next(iter);
+  dbus_message_iter_get_basic(iter, &service_type);
+  dbus_message_iter_next(iter);
+  dbus_message_iter_get_basic(iter, &saved_only);
+
+  if (dbus_message_iter_next(iter) &&
+      dbus_message_iter_get_arg_type(iter) == DBUS_TYPE_ARRAY &&
+      dbus_message_iter_get_element_type(iter) == DBUS_TYPE_BYTE)
+  {
+    dbus_message_iter_recurse(iter, &sub);
+    dbus_message_iter_get_fixed_array(&sub, &network_id, &len);
+  }
+
+  filter->min_signal = min_signal;
+  filter->attrs_required = attrs_required;
+  filter->attrs_forbidden = attrs_forbidden;
+  filter->service_type =
+      service_type && *service_type ? g_strdup(service_type) : NULL;
+  filter->saved_only = saved_only;
+  filter->network_id =
+      network_id && len > 0 && *network_id ? g_strndup(network_id, len) : NULL;
+
+  return TRUE;
+}
+
 static DBusHandlerResult
 icd_dbus_api_scan_req(DBusConnection *conn, DBusMessage *msg, void *user_data)
 {
   const char *sender;
-  GSList *l;
   DBusMessage *reply;
-  gchar *dbus_dest;
+  struct icd_dbus_api_scan_listener *listener;
   struct icd_context *icd_ctx;
   DBusMessageIter reply_str_iter;
   DBusMessageIter iter1;
   DBusMessageIter iter2;
   DBusMessageIter iter3;
+  DBusMessageIter filter_iter;
   struct icd_dbus_api_scan_helper scan_helper;
   guint scan_type = 0;
   struct icd_dbus_api_listeners **listeners = icd_dbus_api_listeners_get();
@@ -943,23 +1334,15 @@ icd_dbus_api_scan_req(DBusConnection *conn, DBusMessage *msg, void *user_data)
 
   sender = dbus_message_get_sender(msg);
 
-  for (l = (*listeners)->scan_listeners; l; l = l->next)
+  if (sender && g_hash_table_lookup((*listeners)->scan_listeners, sender))
   {
-    if (sender)
-    {
-      if (!strcmp((const char *)l->data, sender))
-      {
-        reply = dbus_message_new_error(msg, DBUS_ERROR_LIMITS_EXCEEDED,
-                                       "Scan already started by you");
+    reply = dbus_message_new_error(msg, DBUS_ERROR_LIMITS_EXCEEDED,
+                                   "Scan already started by you");
 
-        if (!reply)
-          return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    if (!reply)
+      return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 
-        goto send_error;
-      }
-    }
-    else
-      ILOG_WARN("icd dbus sender list has NULL item");
+    goto send_error;
   }
 
   dbus_message_iter_init_append(message, &iter1);
@@ -973,12 +1356,28 @@ icd_dbus_api_scan_req(DBusConnection *conn, DBusMessage *msg, void *user_data)
 
   dbus_message_iter_init(msg, &iter3);
   dbus_message_iter_get_basic(&iter3, &scan_type);
-  dbus_dest = g_strdup(dbus_message_get_sender(msg));
-  (*listeners)->scan_listeners = g_slist_prepend((*listeners)->scan_listeners,
-                                                 dbus_dest);
-  icd_name_owner_add_filter(dbus_dest);
+  listener = g_new0(struct icd_dbus_api_scan_listener, 1);
+  listener->dbus_dest = g_strdup(dbus_message_get_sender(msg));
+  listener->flags = scan_type;
+
+  filter_iter = iter3;
+
+  if (dbus_message_iter_next(&filter_iter) &&
+      dbus_message_iter_next(&filter_iter))
+  {
+    listener->filtered = icd_dbus_api_scan_filter_get(&filter_iter,
+                                                      &listener->filter);
+  }
+
+  g_hash_table_insert((*listeners)->scan_listeners, listener->dbus_dest,
+                      listener);
+
+  if (!(listener->flags & ICD_SCAN_REQUEST_BATCHED))
+    (*listeners)->scan_unbatched++;
+
+  icd_name_owner_add_filter(listener->dbus_dest);
   scan_helper.reply_str_iter = &reply_str_iter;
-  scan_helper.dbus_dest = dbus_dest;
+  scan_helper.listener = listener;
   scan_helper.scan_type = scan_type;
 
   if (dbus_message_iter_next(&iter3) &&
@@ -1028,6 +1427,158 @@ send_error:
 
 }
 
+/**
+ * @brief Append a scan result as a struct to a scan results reply array
+ *
+ * @param status status of this network
+ * @param srv_provider service provider entry or NULL
+ * @param cache_entry scan results
+ * @param user_data the reply array iterator
+ *
+ */
+static void
+icd_dbus_api_scan_struct_append(enum icd_scan_status status,
+                                const struct icd_scan_srv_provider *srv_provider,
+                                const struct icd_scan_cache *cache_entry,
+                                gpointer user_data)
+{
+  DBusMessageIter *array = (DBusMessageIter *)user_data;
+  DBusMessageIter sub;
+
+  if (!dbus_message_iter_open_container(array, DBUS_TYPE_STRUCT, NULL, &sub) ||
+      !icd_dbus_api_scan_append_args(&sub, status, srv_provider, cache_entry) ||
+      !dbus_message_iter_close_container(array, &sub))
+  {
+    ILOG_CRIT("dbus api out of memory when appending scan results");
+  }
+}
+
+static DBusHandlerResult
+icd_dbus_api_scan_changes_req(DBusConnection *conn, DBusMessage *msg,
+                              void *user_data)
+{
+  DBusMessage *reply;
+  DBusMessageIter iter;
+  DBusMessageIter array;
+  dbus_uint32_t epoch = 0;
+  dbus_uint32_t generation = 0;
+  dbus_bool_t delta;
+
+  dbus_message_get_args(msg, NULL,
+                        DBUS_TYPE_UINT32, &epoch,
+                        DBUS_TYPE_UINT32, &generation,
+                        DBUS_TYPE_INVALID);
+
+  reply = dbus_message_new_method_return(msg);
+
+  if (!reply)
+    goto oom;
+
+  dbus_message_iter_init_append(reply, &iter);
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+                                        ICD_DBUS_API_SCAN_RESULT_SIGNATURE,
+                                        &array))
+  {
+    dbus_message_unref(reply);
+    goto oom;
+  }
+
+  delta = icd_scan_cache_changes(epoch, generation,
+                                 icd_dbus_api_scan_struct_append, &array);
+  epoch = icd_scan_cache_epoch();
+  generation = icd_scan_cache_generation();
+
+  if (!dbus_message_iter_close_container(&iter, &array) ||
+      !dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32, &epoch) ||
+      !dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32, &generation) ||
+      !dbus_message_iter_append_basic(&iter, DBUS_TYPE_BOOLEAN, &delta))
+  {
+    dbus_message_unref(reply);
+    goto oom;
+  }
+
+  ILOG_DEBUG("dbus api sending scan cache %s up to generation %u/%u",
+             delta ? "changes" : "snapshot", epoch, generation);
+
+  icd_dbus_send_system_msg(reply);
+  dbus_message_unref(reply);
+
+  return DBUS_HANDLER_RESULT_HANDLED;
+
+oom:
+  reply = dbus_message_new_error(msg, DBUS_ERROR_NO_MEMORY,
+                                 "Out of memory when creating reply");
+
+  if (!reply)
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+  icd_dbus_send_system_msg(reply);
+  dbus_message_unref(reply);
+
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+static DBusHandlerResult
+icd_dbus_api_scan_cache_get_req(DBusConnection *conn, DBusMessage *msg,
+                                void *user_data)
+{
+  DBusMessage *reply;
+  DBusMessageIter iter;
+  DBusMessageIter array;
+  const gchar *network_type = NULL;
+  dbus_uint32_t max_age = 0;
+
+  dbus_message_get_args(msg, NULL,
+                        DBUS_TYPE_STRING, &network_type,
+                        DBUS_TYPE_UINT32, &max_age,
+                        DBUS_TYPE_INVALID);
+
+  if (network_type && !*network_type)
+    network_type = NULL;
+
+  reply = dbus_message_new_method_return(msg);
+
+  if (!reply)
+    goto oom;
+
+  dbus_message_iter_init_append(reply, &iter);
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+                                        ICD_DBUS_API_SCAN_RESULT_SIGNATURE,
+                                        &array))
+  {
+    dbus_message_unref(reply);
+    goto oom;
+  }
+
+  icd_scan_cache_foreach(network_type, max_age,
+                         icd_dbus_api_scan_struct_append, &array);
+
+  if (!dbus_message_iter_close_container(&iter, &array))
+  {
+    dbus_message_unref(reply);
+    goto oom;
+  }
+
+  icd_dbus_send_system_msg(reply);
+  dbus_message_unref(reply);
+
+  return DBUS_HANDLER_RESULT_HANDLED;
+
+oom:
+  reply = dbus_message_new_error(msg, DBUS_ERROR_NO_MEMORY,
+                                 "Out of memory when creating reply");
+
+  if (!reply)
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+  icd_dbus_send_system_msg(reply);
+  dbus_message_unref(reply);
+
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
 static DBusHandlerResult
 icd_dbus_api_connect_req(DBusConnection *conn, DBusMessage *msg,
                          void *user_data)
@@ -1160,7 +1711,16 @@ icd_dbus_api_connect_req(DBusConnection *conn, DBusMessage *msg,
 static const struct icd_dbus_mcall_table icd_dbus_api_mcalls[] = {
  {ICD_DBUS_API_SCAN_REQ, "u", "as", icd_dbus_api_scan_req},
  {ICD_DBUS_API_SCAN_REQ, "uas", "as", icd_dbus_api_scan_req},
+ {ICD_DBUS_API_SCAN_REQ, "uasiuusb", "as", icd_dbus_api_scan_req},
+ {ICD_DBUS_API_SCAN_REQ, "uasiuusbay", "as", icd_dbus_api_scan_req},
  {ICD_DBUS_API_SCAN_CANCEL, "", "", icd_dbus_api_scan_cancel},
+ {ICD_DBUS_API_SCAN_CHANGES_REQ, "uu",
+  "a" ICD_DBUS_API_SCAN_RESULT_SIGNATURE "uub",
+  icd_dbus_api_scan_changes_req},
+ {ICD_DBUS_API_SCAN_CACHE_GET_REQ, "", "a" ICD_DBUS_API_SCAN_RESULT_SIGNATURE,
+  icd_dbus_api_scan_cache_get_req},
+ {ICD_DBUS_API_SCAN_CACHE_GET_REQ, "su", "a" ICD_DBUS_API_SCAN_RESULT_SIGNATURE,
+  icd_dbus_api_scan_cache_get_req},
  {ICD_DBUS_API_CONNECT_REQ, "u", "", icd_dbus_api_connect_req},
  {ICD_DBUS_API_CONNECT_REQ, "ua(sussuay)", "", icd_dbus_api_connect_req},
  {ICD_DBUS_API_SELECT_REQ, "u", "", icd_dbus_api_select_req},
@@ -1168,6 +1728,8 @@ static const struct icd_dbus_mcall_table icd_dbus_api_mcalls[] = {
  {ICD_DBUS_API_DISCONNECT_REQ, "u", "", icd_dbus_api_disconnect_req},
  {ICD_DBUS_API_STATE_REQ, "sussuay", "u", icd_dbus_api_state_req},
  {ICD_DBUS_API_STATE_REQ, "", "u", icd_dbus_api_state_req},
+ {ICD_DBUS_API_STATE_SNAPSHOT_REQ, "", "a(sussuaysub)as",
+  icd_dbus_api_state_snapshot_req},
  {ICD_DBUS_API_STATISTICS_REQ, "sussuay", "u", icd_dbus_api_statistics_req},
  {ICD_DBUS_API_STATISTICS_REQ, "", "u", icd_dbus_api_statistics_req},
  {ICD_DBUS_API_ADDRINFO_REQ, "sussuay", "u", icd_dbus_api_addrinfo_req},
@@ -1175,6 +1737,20 @@ static const struct icd_dbus_mcall_table icd_dbus_api_mcalls[] = {
  {NULL}
 };
 
+/**
+ * @brief Get the method call dispatch table
+ *
+ * @return pointer to the dispatch table pointer
+ *
+ */
+static struct icd_dbus_dispatch **
+icd_dbus_api_dispatch_get(void)
+{
+  static struct icd_dbus_dispatch *dispatch = NULL;
+
+  return &dispatch;
+}
+
 /**
  * @brief Notify ICd2 D-Bus API when an app goes away
  *
@@ -1186,34 +1762,30 @@ static const struct icd_dbus_mcall_table icd_dbus_api_mcalls[] = {
 gboolean
 icd_dbus_api_app_exit(const gchar *dbus_dest)
 {
-  gboolean rv = FALSE;
   struct icd_dbus_api_listeners **listeners = icd_dbus_api_listeners_get();
-  GSList *l = (*listeners)->scan_listeners;
+  struct icd_dbus_api_scan_listener *listener;
 
-  while (l)
-  {
-    gchar *listener = (gchar *)l->data;
-    GSList *next = l->next;
+  if (!dbus_dest)
+    return FALSE;
 
-    if (listener)
-    {
-      if (!strcmp(listener, dbus_dest))
-      {
-        ILOG_INFO("dbus api removed scanning for app '%s'", dbus_dest);
-
-        (*listeners)->scan_listeners =
-            g_slist_delete_link((*listeners)->scan_listeners, l);
-        icd_scan_results_unregister(icd_dbus_api_scan_result, listener);
-        icd_name_owner_remove_filter(dbus_dest);
-        g_free(listener);
-        rv = TRUE;
-      }
-    }
+  listener = (struct icd_dbus_api_scan_listener *)
+      g_hash_table_lookup((*listeners)->scan_listeners, dbus_dest);
 
-    l = next;
-  }
+  if (!listener)
+    return FALSE;
 
-  return rv;
+  ILOG_INFO("dbus api removed scanning for app '%s'", dbus_dest);
+
+  g_hash_table_remove((*listeners)->scan_listeners, dbus_dest);
+
+  if (!(listener->flags & ICD_SCAN_REQUEST_BATCHED))
+    (*listeners)->scan_unbatched--;
+
+  icd_scan_results_unregister(icd_dbus_api_scan_result, listener);
+  icd_name_owner_remove_filter(dbus_dest);
+  icd_dbus_api_scan_listener_free(listener);
+
+  return TRUE;
 }
 
 /**
@@ -1223,7 +1795,15 @@ icd_dbus_api_app_exit(const gchar *dbus_dest)
 void
 icd_dbus_api_deinit(void)
 {
+  struct icd_dbus_dispatch **dispatch = icd_dbus_api_dispatch_get();
+  struct icd_dbus_api_listeners **listeners = icd_dbus_api_listeners_get();
+
   icd_dbus_unregister_system_service(ICD_DBUS_API_PATH, ICD_DBUS_API_INTERFACE);
+
+  icd_dbus_dispatch_free(*dispatch);
+  *dispatch = NULL;
+
+  g_hash_table_remove_all((*listeners)->scan_templates);
 }
 
 /**
@@ -1238,36 +1818,27 @@ static DBusHandlerResult
 icd_dbus_api_request(DBusConnection *connection, DBusMessage *message,
                      void *user_data)
 {
+  struct icd_dbus_dispatch_entry *entry;
+  DBusObjectPathMessageFunction handler_fn;
+  DBusHandlerResult result;
   DBusMessage *err_msg;
-  int i = 0;
-  const char *iface = dbus_message_get_interface(message);
+  gint64 start;
+
+  entry = icd_dbus_dispatch_find(*icd_dbus_api_dispatch_get(), message);
 
-  if (iface && !strcmp(iface, ICD_DBUS_API_INTERFACE))
+  if (entry)
   {
-    while (icd_dbus_api_mcalls[i].name)
-    {
-      if (!strcmp(dbus_message_get_member(message),
-                  icd_dbus_api_mcalls[i].name))
-      {
-        if (icd_dbus_api_mcalls[i].mcall_sig &&
-            dbus_message_has_signature(message,
-                                       icd_dbus_api_mcalls[i].mcall_sig))
-        {
-          if (icd_dbus_api_mcalls[i].handler_fn)
-          {
-            ILOG_INFO("Received %s.%s (%s) request",
-                      dbus_message_get_interface(message),
-                      dbus_message_get_member(message),
-                      dbus_message_get_signature(message));
+    ILOG_INFO("Received %s.%s (%s) request",
+              dbus_message_get_interface(message),
+              dbus_message_get_member(message),
+              dbus_message_get_signature(message));
 
-            return icd_dbus_api_mcalls[i].handler_fn(connection, message,
-                                                     user_data);
-          }
-        }
-      }
+    handler_fn = (DBusObjectPathMessageFunction)entry->handler;
+    start = g_get_monotonic_time();
+    result = handler_fn(connection, message, user_data);
+    icd_dbus_dispatch_done(entry, start);
 
-      i++;
-    }
+    return result;
   }
 
   ILOG_INFO("received '%s.%s' request has no handler implemented",
@@ -1291,6 +1862,20 @@ icd_dbus_api_request(DBusConnection *connection, DBusMessage *message,
 gboolean
 icd_dbus_api_init(void)
 {
+  struct icd_dbus_dispatch **dispatch = icd_dbus_api_dispatch_get();
+  const struct icd_dbus_mcall_table *mcall;
+
+  *dispatch = icd_dbus_dispatch_new(ICD_DBUS_API_INTERFACE);
+
+  for (mcall = icd_dbus_api_mcalls; mcall->name; mcall++)
+  {
+    if (mcall->mcall_sig && mcall->handler_fn)
+    {
+      icd_dbus_dispatch_add(*dispatch, ICD_DBUS_API_INTERFACE, mcall->name,
+                            mcall->mcall_sig, mcall->handler_fn);
+    }
+  }
+
   icd_dbus_api_update_state(NULL, NULL, ICD_STATE_DISCONNECTED);
 
   return icd_dbus_register_system_service(ICD_DBUS_API_PATH,
@@ -1383,21 +1968,16 @@ icd_dbus_api_update_state(struct icd_iap *iap, const gchar *destination,
 }
 
 /**
- * @brief Function for sending state data to listeners
+ * @brief Get the D-Bus API connection state of an IAP
  *
  * @param iap the IAP
- * @param foreach_data foreach data structure
  *
- * @return TRUE on successful signal sending, FALSE on error
+ * @return the connection state
  *
  */
-static gboolean
-icd_dbus_api_state_send(struct icd_iap *iap,
-                        struct icd_dbus_api_foreach_data *foreach_data)
+static enum icd_connection_state
+icd_dbus_api_state_get(struct icd_iap *iap)
 {
-  const gchar *dest = foreach_data->sender;
-  gboolean rv;
-
   switch (iap->state)
   {
     case ICD_IAP_STATE_SCRIPT_PRE_UP:
@@ -1406,37 +1986,41 @@ icd_dbus_api_state_send(struct icd_iap *iap,
     case ICD_IAP_STATE_IP_UP:
     case ICD_IAP_STATE_SCRIPT_POST_UP:
     case ICD_IAP_STATE_SAVING:
-      rv = icd_dbus_api_update_state(iap, dest, ICD_STATE_CONNECTING);
-      break;
+      return ICD_STATE_CONNECTING;
     case ICD_IAP_STATE_SRV_UP:
-    {
-      enum icd_connection_state conn_state;
-
       if (iap->limited_conn)
-        conn_state = ICD_STATE_LIMITED_CONN_ENABLED;
+        return ICD_STATE_LIMITED_CONN_ENABLED;
       else
-        conn_state = ICD_STATE_CONNECTING;
-
-      rv = icd_dbus_api_update_state(iap, dest, conn_state);
-      break;
-    }
+        return ICD_STATE_CONNECTING;
     case ICD_IAP_STATE_CONNECTED:
-      rv = icd_dbus_api_update_state(iap, dest, ICD_STATE_CONNECTED);
-      break;
+      return ICD_STATE_CONNECTED;
     case ICD_IAP_STATE_CONNECTED_DOWN:
     case ICD_IAP_STATE_SRV_DOWN:
     case ICD_IAP_STATE_IP_DOWN:
     case ICD_IAP_STATE_LINK_PRE_DOWN:
     case ICD_IAP_STATE_LINK_DOWN:
     case ICD_IAP_STATE_SCRIPT_POST_DOWN:
-      rv = icd_dbus_api_update_state(iap, dest, ICD_STATE_DISCONNECTING);
-      break;
+      return ICD_STATE_DISCONNECTING;
     default:
-      rv = icd_dbus_api_update_state(iap, dest, ICD_STATE_DISCONNECTED);
-      break;
+      return ICD_STATE_DISCONNECTED;
   }
+}
 
-  return rv;
+/**
+ * @brief Function for sending state data to listeners
+ *
+ * @param iap the IAP
+ * @param foreach_data foreach data structure
+ *
+ * @return TRUE on successful signal sending, FALSE on error
+ *
+ */
+static gboolean
+icd_dbus_api_state_send(struct icd_iap *iap,
+                        struct icd_dbus_api_foreach_data *foreach_data)
+{
+  return icd_dbus_api_update_state(iap, foreach_data->sender,
+                                   icd_dbus_api_state_get(iap));
 }
 
 /**
@@ -1631,6 +2215,149 @@ icd_dbus_api_state_req(DBusConnection *conn, DBusMessage *msg, void *user_data)
   return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 }
 
+/**
+ * @brief Append the state of an IAP to the state snapshot
+ *
+ * @param iap the IAP
+ * @param user_data the array iterator of the state snapshot
+ *
+ * @return TRUE to go through all IAPs, FALSE if out of memory
+ *
+ */
+static gboolean
+icd_dbus_api_state_snapshot_iap(struct icd_iap *iap, gpointer user_data)
+{
+  DBusMessageIter *array = (DBusMessageIter *)user_data;
+  DBusMessageIter iter;
+  DBusMessageIter sub;
+  const gchar *empty = "";
+  const gchar *service_type;
+  const gchar *service_id;
+  const gchar *network_type;
+  const gchar *network_id;
+  const gchar *err_str;
+  dbus_uint32_t state = icd_dbus_api_state_get(iap);
+  dbus_bool_t limited_conn = iap->limited_conn ? TRUE : FALSE;
+
+  service_type = iap->connection.service_type ?
+        iap->connection.service_type : empty;
+  service_id = iap->connection.service_id ? iap->connection.service_id : empty;
+  network_type = iap->connection.network_type ?
+        iap->connection.network_type : empty;
+  network_id = iap->connection.network_id ? iap->connection.network_id : empty;
+  err_str = iap->err_str ? iap->err_str : empty;
+
+  if (dbus_message_iter_open_container(array, DBUS_TYPE_STRUCT, NULL, &iter) &&
+      dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &service_type) &&
+      dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32,
+                                     &iap->connection.service_attrs) &&
+      dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &service_id) &&
+      dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &network_type) &&
+      dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32,
+                                     &iap->connection.network_attrs) &&
+      dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+                                       DBUS_TYPE_BYTE_AS_STRING, &sub) &&
+      dbus_message_iter_append_fixed_array(&sub, DBUS_TYPE_BYTE, &network_id,
+                                           strlen(network_id) + 1) &&
+      dbus_message_iter_close_container(&iter, &sub) &&
+      dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &err_str) &&
+      dbus_message_iter_append_basic(&iter, DBUS_TYPE_UINT32, &state) &&
+      dbus_message_iter_append_basic(&iter, DBUS_TYPE_BOOLEAN,
+                                     &limited_conn) &&
+      dbus_message_iter_close_container(array, &iter))
+  {
+    return TRUE;
+  }
+
+  ILOG_CRIT("dbus api out of memory when appending IAP state");
+
+  return FALSE;
+}
+
+/**
+ * @brief Append the network types being searched to the state snapshot
+ *
+ * @param module the network module
+ * @param user_data the array iterator of the state snapshot
+ *
+ * @return TRUE to go through all modules, FALSE if out of memory
+ *
+ */
+static gboolean
+icd_dbus_api_state_snapshot_scanning(struct icd_network_module *module,
+                                     gpointer user_data)
+{
+  DBusMessageIter *array = (DBusMessageIter *)user_data;
+  GSList *l;
+
+  if (!module->scan_progress)
+    return TRUE;
+
+  for (l = module->network_types; l; l = l->next)
+  {
+    const gchar *network_type = (const gchar *)l->data;
+
+    if (network_type &&
+        !dbus_message_iter_append_basic(array, DBUS_TYPE_STRING,
+                                        &network_type))
+    {
+      ILOG_CRIT("dbus api out of memory when appending scanning state");
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+ * @brief Handle state snapshot requests; the state of all IAPs and network
+ * searches is returned in the method call return
+ *
+ * @param conn D-Bus connection
+ * @param msg D-Bus message
+ * @param user_data dbus client data
+ *
+ */
+static DBusHandlerResult
+icd_dbus_api_state_snapshot_req(DBusConnection *conn, DBusMessage *msg,
+                                void *user_data)
+{
+  DBusMessage *reply;
+  DBusMessageIter iter;
+  DBusMessageIter array;
+
+  reply = dbus_message_new_method_return(msg);
+
+  if (!reply)
+  {
+    ILOG_ERR("dbus api cannot create state snapshot req mcall return");
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+  }
+
+  dbus_message_iter_init_append(reply, &iter);
+
+  if (!dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+                                        "(sussuaysub)", &array) ||
+      icd_iap_foreach(icd_dbus_api_state_snapshot_iap, &array) ||
+      !dbus_message_iter_close_container(&iter, &array) ||
+      !dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+                                        DBUS_TYPE_STRING_AS_STRING, &array) ||
+      icd_network_api_foreach_module(icd_context_get(),
+                                     icd_dbus_api_state_snapshot_scanning,
+                                     &array) ||
+      !dbus_message_iter_close_container(&iter, &array))
+  {
+    ILOG_ERR("dbus_api could not add args to state snapshot mcall return");
+    dbus_message_unref(reply);
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+  }
+
+  icd_dbus_send_system_msg(reply);
+  dbus_message_unref(reply);
+
+  return DBUS_HANDLER_RESULT_HANDLED;
+}
+
 static
 gboolean
 icd_dbus_api_send_connect_sig(enum icd_connect_status status,
@@ -0,0 +1,250 @@
+#include <string.h>
+
+#include "icd_log.h"
+#include "icd_dbus_dispatch.h"
+#include "icd_string.h"
+
+/**
+ * @brief Hash function for dispatch entries
+ *
+ * @param key the #icd_dbus_dispatch_entry
+ *
+ * @return hash of interface, member and signature
+ *
+ */
+static guint
+icd_dbus_dispatch_hash(gconstpointer key)
+{
+  const struct icd_dbus_dispatch_entry *entry =
+      (const struct icd_dbus_dispatch_entry *)key;
+  guint hash = g_str_hash(entry->interface);
+
+  hash = hash * 31 + g_str_hash(entry->member);
+
+  if (entry->signature)
+    hash = hash * 31 + g_str_hash(entry->signature);
+
+  return hash;
+}
+
+/**
+ * @brief Equality function for dispatch entries
+ *
+ * @param a the first #icd_dbus_dispatch_entry
+ * @param b the second #icd_dbus_dispatch_entry
+ *
+ * @return TRUE if interface, member and signature are equal
+ *
+ */
+static gboolean
+icd_dbus_dispatch_equal(gconstpointer a, gconstpointer b)
+{
+  const struct icd_dbus_dispatch_entry *entry_a =
+      (const struct icd_dbus_dispatch_entry *)a;
+  const struct icd_dbus_dispatch_entry *entry_b =
+      (const struct icd_dbus_dispatch_entry *)b;
+
+  return !strcmp(entry_a->interface, entry_b->interface) &&
+      !strcmp(entry_a->member, entry_b->member) &&
+      icd_string_equal(entry_a->signature, entry_b->signature);
+}
+
+/**
+ * @brief Get the list of existing dispatch tables
+ *
+ * @return pointer to the list of #icd_dbus_dispatch tables
+ *
+ */
+static GSList **
+icd_dbus_dispatch_tables_get(void)
+{
+  static GSList *tables = NULL;
+
+  return &tables;
+}
+
+/**
+ * @brief Create a D-Bus dispatch table
+ *
+ * @param name name of the table for log messages
+ *
+ * @return the dispatch table
+ *
+ */
+struct icd_dbus_dispatch *
+icd_dbus_dispatch_new(const gchar *name)
+{
+  struct icd_dbus_dispatch *dispatch = g_new0(struct icd_dbus_dispatch, 1);
+
+  dispatch->name = g_strdup(name);
+  dispatch->entries = g_hash_table_new_full(icd_dbus_dispatch_hash,
+                                            icd_dbus_dispatch_equal,
+                                            NULL, g_free);
+  *icd_dbus_dispatch_tables_get() =
+      g_slist_prepend(*icd_dbus_dispatch_tables_get(), dispatch);
+
+  return dispatch;
+}
+
+/**
+ * @brief Add a handler to a D-Bus dispatch table; the strings are not copied
+ *
+ * @param dispatch the dispatch table
+ * @param interface D-Bus interface
+ * @param member D-Bus member
+ * @param signature D-Bus signature or NULL to match any signature
+ * @param handler handler function
+ *
+ */
+void
+icd_dbus_dispatch_add(struct icd_dbus_dispatch *dispatch,
+                      const gchar *interface, const gchar *member,
+                      const gchar *signature, gpointer handler)
+{
+  struct icd_dbus_dispatch_entry *entry;
+
+  if (!dispatch || !interface || !member)
+  {
+    ILOG_ERR("dispatch table, interface or member not given");
+    return;
+  }
+
+  entry = g_new0(struct icd_dbus_dispatch_entry, 1);
+  entry->interface = interface;
+  entry->member = member;
+  entry->signature = signature;
+  entry->handler = handler;
+
+  g_hash_table_replace(dispatch->entries, entry, entry);
+}
+
+/**
+ * @brief Find the handler for a D-Bus message; a handler for the exact
+ * signature is preferred over one accepting any signature
+ *
+ * @param dispatch the dispatch table
+ * @param message the D-Bus message
+ *
+ * @return the dispatch entry or NULL if there is no handler
+ *
+ */
+struct icd_dbus_dispatch_entry *
+icd_dbus_dispatch_find(struct icd_dbus_dispatch *dispatch,
+                       DBusMessage *message)
+{
+  struct icd_dbus_dispatch_entry key;
+  struct icd_dbus_dispatch_entry *entry;
+
+  if (!dispatch)
+    return NULL;
+
+  key.interface = dbus_message_get_interface(message);
+  key.member = dbus_message_get_member(message);
+  key.signature = dbus_message_get_signature(message);
+
+  if (!key.interface || !key.member)
+    return NULL;
+
+  entry = (struct icd_dbus_dispatch_entry *)
+      g_hash_table_lookup(dispatch->entries, &key);
+
+  if (!entry)
+  {
+    key.signature = NULL;
+    entry = (struct icd_dbus_dispatch_entry *)
+        g_hash_table_lookup(dispatch->entries, &key);
+  }
+
+  return entry;
+}
+
+/**
+ * @brief Record a handled message in the call statistics
+ *
+ * @param entry the dispatch entry of the handler
+ * @param start monotonic time in microseconds when the handler was called
+ *
+ */
+void
+icd_dbus_dispatch_done(struct icd_dbus_dispatch_entry *entry,
+                       const gint64 start)
+{
+  gint64 usec = g_get_monotonic_time() - start;
+
+  entry->calls++;
+  entry->usec_total += usec;
+
+  if (usec > entry->usec_max)
+    entry->usec_max = usec;
+
+  if (usec >= G_USEC_PER_SEC / 10)
+  {
+    ILOG_WARN("handling %s.%s (%s) took %u ms", entry->interface,
+              entry->member, entry->signature ? entry->signature : "*",
+              (guint)(usec / 1000));
+  }
+}
+
+/**
+ * @brief Log the call statistics of a dispatch entry
+ *
+ * @param key the dispatch entry
+ * @param value the dispatch entry
+ * @param user_data the dispatch table
+ *
+ */
+static void
+icd_dbus_dispatch_log_entry(gpointer key, gpointer value, gpointer user_data)
+{
+  struct icd_dbus_dispatch_entry *entry =
+      (struct icd_dbus_dispatch_entry *)value;
+  struct icd_dbus_dispatch *dispatch = (struct icd_dbus_dispatch *)user_data;
+
+  if (!entry->calls)
+    return;
+
+  ILOG_INFO("%s: %s.%s (%s) called %u times, %u us average, %u us max",
+            dispatch->name, entry->interface, entry->member,
+            entry->signature ? entry->signature : "*", entry->calls,
+            (guint)(entry->usec_total / entry->calls), entry->usec_max);
+}
+
+/**
+ * @brief Log the call statistics of all dispatch tables; can be triggered at
+ * runtime with SIGUSR2
+ *
+ */
+void
+icd_dbus_dispatch_log_stats(void)
+{
+  GSList *l;
+
+  for (l = *icd_dbus_dispatch_tables_get(); l; l = l->next)
+  {
+    struct icd_dbus_dispatch *dispatch = (struct icd_dbus_dispatch *)l->data;
+
+    g_hash_table_foreach(dispatch->entries, icd_dbus_dispatch_log_entry,
+                         dispatch);
+  }
+}
+
+/**
+ * @brief Free a D-Bus dispatch table and log its call statistics
+ *
+ * @param dispatch the dispatch table
+ *
+ */
+void
+icd_dbus_dispatch_free(struct icd_dbus_dispatch *dispatch)
+{
+  if (!dispatch)
+    return;
+
+  *icd_dbus_dispatch_tables_get() =
+      g_slist_remove(*icd_dbus_dispatch_tables_get(), dispatch);
+  g_hash_table_foreach(dispatch->entries, icd_dbus_dispatch_log_entry,
+                       dispatch);
+  g_hash_table_destroy(dispatch->entries);
+  g_free(dispatch->name);
+  g_free(dispatch);
+}
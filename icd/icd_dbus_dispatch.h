@@ -0,0 +1,59 @@
+#ifndef ICD_DBUS_DISPATCH_H
+#define ICD_DBUS_DISPATCH_H
+
+#include <glib.h>
+#include <dbus/dbus.h>
+
+/** D-Bus method call or signal handler and its call statistics */
+struct icd_dbus_dispatch_entry {
+  /** D-Bus interface */
+  const gchar *interface;
+
+  /** D-Bus member */
+  const gchar *member;
+
+  /** D-Bus signature or NULL for any */
+  const gchar *signature;
+
+  /** handler function, called by the user of the dispatch table */
+  gpointer handler;
+
+  /** number of handled messages */
+  guint calls;
+
+  /** total time spent in the handler in microseconds */
+  guint64 usec_total;
+
+  /** longest time spent in the handler in microseconds */
+  guint usec_max;
+};
+
+/** D-Bus dispatch table */
+struct icd_dbus_dispatch {
+  /** name of the table for log messages */
+  gchar *name;
+
+  /** #icd_dbus_dispatch_entry by interface, member and signature */
+  GHashTable *entries;
+};
+
+struct icd_dbus_dispatch *icd_dbus_dispatch_new (const gchar *name);
+
+void icd_dbus_dispatch_add (struct icd_dbus_dispatch *dispatch,
+                            const gchar *interface,
+                            const gchar *member,
+                            const gchar *signature,
+                            gpointer handler);
+
+struct icd_dbus_dispatch_entry *
+icd_dbus_dispatch_find (struct icd_dbus_dispatch *dispatch,
+                        DBusMessage *message);
+
+void icd_dbus_dispatch_done (struct icd_dbus_dispatch_entry *entry,
+                             const gint64 start);
+
+void icd_dbus_dispatch_log_stats (void);
+
+void icd_dbus_dispatch_free (struct icd_dbus_dispatch *dispatch);
+
+#endif
@@ -27,6 +27,7 @@
 #include "icd_dbus_api.h"
 #include "icd_srv_provider.h"
 #include "icd_network_priority.h"
+#include "icd_dbus_dispatch.h"
 
 
 #define PIDFILE "/var/run/icd2.pid"
@@ -119,6 +120,9 @@ icd_exec_signal_cb(int sig)
     case SIGUSR1:
       icd_log_nextlevel();
       break;
+    case SIGUSR2:
+      icd_dbus_dispatch_log_stats();
+      break;
     case SIGCHLD:
       while (1)
       {
@@ -158,6 +162,11 @@ main(int argc, char **argv)
 
   ILOG_INFO(PACKAGE" version "ICD_NW_MODULE_VERSION" starting");
 
+#if !GLIB_CHECK_VERSION (2,32,0)
+  if (!g_thread_supported())
+    g_thread_init(NULL);
+#endif
+
 #if !GLIB_CHECK_VERSION (2,35,0)
   g_type_init();
 #endif
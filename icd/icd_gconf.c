@@ -52,6 +52,48 @@ icd_gconf_get_iap_bool(const char *iap_name, const char *key_name, gboolean def)
   return rv;
 }
 
+gint
+icd_gconf_get_iap_int_default(const char *iap_name, const char *key_name,
+                              gint def)
+{
+  GConfClient *gconf = gconf_client_get_default();
+  gchar *key;
+  GConfValue *val;
+  gint rv = def;
+  GError *err = NULL;
+
+  if (iap_name)
+  {
+    gchar *s = gconf_escape_key(iap_name, -1);
+    key = g_strdup_printf(ICD_GCONF_PATH  "/%s/%s", s, key_name);
+    g_free(s);
+  }
+  else
+    key = g_strdup_printf(ICD_GCONF_PATH "/%s", key_name);
+
+  val = gconf_client_get(gconf, key, &err);
+  g_free(key);
+  icd_gconf_check_error(&err);
+
+  if (val)
+  {
+    if (G_VALUE_HOLDS_INT(val))
+      rv = gconf_value_get_int(val);
+
+    gconf_value_free(val);
+  }
+
+  g_object_unref(gconf);
+
+  return rv;
+}
+
+gint
+icd_gconf_get_iap_int(const char *iap_name, const char *key_name)
+{
+  return icd_gconf_get_iap_int_default(iap_name, key_name, 0);
+}
+
 gboolean
 icd_gconf_is_temporary(const gchar *settings_name)
 {
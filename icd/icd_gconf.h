@@ -11,6 +11,16 @@
 
 #define ICD_GCONF_AGGRESSIVE_SCANNING "aggressive_scanning"
 
+#define ICD_GCONF_SCAN_INTERVAL_MAX "scan_interval_max"
+
+#define ICD_GCONF_SCAN_DB_HYSTERESIS "scan_db_hysteresis"
+
+#define ICD_GCONF_SCAN_NOTIFY_INTERVAL "scan_notify_interval"
+
+#define ICD_GCONF_SCAN_FRESH_AGE "scan_fresh_age"
+
+#define ICD_GCONF_SCAN_CACHE_MAX "scan_cache_max"
+
 gchar *icd_gconf_get_iap_string (const char *iap_name,
                                  const char *key_name);
 gchar *icd_gconf_get_iap_bytearray (const char *iap_name,
@@ -20,6 +30,9 @@ gboolean icd_gconf_get_iap_bool (const char *iap_name,
                                  gboolean def);
 gint icd_gconf_get_iap_int (const char *iap_name,
                             const char *key_name);
+gint icd_gconf_get_iap_int_default (const char *iap_name,
+                                    const char *key_name,
+                                    gint def);
 GSList* icd_gconf_get_iap_string_list (const char *iap_name,
                                        const char *key_name);
 
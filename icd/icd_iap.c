@@ -19,6 +19,7 @@
 #include "icd_status.h"
 #include "icd_srv_provider.h"
 #include "icd_dbus_api.h"
+#include "icd_string.h"
 
 static gboolean icd_iap_run_restart(struct icd_iap *iap);
 static gboolean icd_iap_run_renew(struct icd_iap *iap);
@@ -69,28 +70,6 @@ static const gchar *icd_iap_layer_names[] = {
   "ICD_NW_LAYER_ALL"
 };
 
-/**
- * @brief Helper function for comparing two strings where a NULL string is equal
- * to another NULL string
- *
- * @param a string A
- * @param b string B
- *
- * @return TRUE if equal, FALSE if unequal
- *
- */
-inline static gboolean
-string_equal(const char *a, const char *b)
-{
-  if (!a)
-    return !b;
-
-  if (b)
-    return !strcmp(a, b);
-
-  return FALSE;
-}
-
 /**
  * @brief Iterate over all active IAPs
  *
@@ -665,8 +644,8 @@ icd_iap_find(const gchar *network_type, const guint network_attrs,
              (iap->connection.network_attrs & ICD_NW_ATTR_LOCALMASK) ||
              (iap->connection.network_attrs & ICD_NW_ATTR_IAPNAME) ==
              (network_attrs & ICD_NW_ATTR_IAPNAME)) &&
-            string_equal(network_type, iap->connection.network_type) &&
-            string_equal(network_id, iap->connection.network_id))
+            icd_string_equal(network_type, iap->connection.network_type) &&
+            icd_string_equal(network_id, iap->connection.network_id))
         {
           ILOG_DEBUG("IAP for %s/%0x/%s found", network_type, network_attrs,
                      network_id);
@@ -789,23 +768,15 @@ icd_iap_free(struct icd_iap *iap)
     {
       struct icd_network_module *module =
           (struct icd_network_module *)g_slist_nth_data(iap->current_module, 0);
-      struct icd_scan_cache_list *cache_list =
-          icd_scan_cache_list_lookup(module, iap->connection.network_id);
 
-      if (cache_list)
+      if (icd_scan_cache_entry_remove(module, iap->connection.network_id,
+                                      iap->connection.network_type,
+                                      iap->connection.network_attrs))
       {
-        ILOG_DEBUG("IAP %s found in the cache list, removing it.",
-                   iap->connection.network_id);
-
-        if (icd_scan_cache_entry_remove(cache_list, iap->connection.network_id,
-                                        iap->connection.network_type,
-                                        iap->connection.network_attrs))
-        {
-          ILOG_DEBUG("Removed temp IAP %p from cache.", iap);
-        }
-        else
-          ILOG_DEBUG("Temp IAP %p not found in cache.", iap);
+        ILOG_DEBUG("Removed temp IAP %p from cache.", iap);
       }
+      else
+        ILOG_DEBUG("Temp IAP %p not found in cache.", iap);
     }
   }
 
@@ -1702,7 +1673,7 @@ icd_iap_find_by_id(const gchar *iap_id, const gboolean is_local)
         {
             struct icd_iap *iap = (struct icd_iap *)request->try_iaps->data;
 
-          if (string_equal(iap_id, iap->id) && iap->id_is_local == is_local)
+          if (icd_string_equal(iap_id, iap->id) && iap->id_is_local == is_local)
           {
             ILOG_DEBUG("IAP for %s and local %s found", iap_id,
                        is_local ? "TRUE" : "FALSE");
@@ -11,7 +11,25 @@
 #include "icd_tracking_info.h"
 #include "icd_dbus_api.h"
 
-#define ICD_NAME_OWNER_FILTER_STRING   "member='NameOwnerChanged',arg0='%s'"
+#define ICD_NAME_OWNER_FILTER_STRING   "member='NameOwnerChanged'"
+
+/**
+ * @brief Get the table of tracked D-Bus names; the value is the number of
+ * times the name has been added
+ *
+ * @return the tracked names
+ *
+ */
+static GHashTable *
+icd_name_owner_get_names(void)
+{
+  static GHashTable *names = NULL;
+
+  if (!names)
+    names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+  return names;
+}
 
 /**
  * @brief D-Bus filter function for NameOwnerChanged messages
@@ -45,6 +63,9 @@ icd_name_owner_filter(DBusConnection *connection, DBusMessage *message,
     return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
   }
 
+  if (!g_hash_table_lookup(icd_name_owner_get_names(), name))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
   if (*new)
   {
     if (*old)
@@ -52,17 +73,8 @@ icd_name_owner_filter(DBusConnection *connection, DBusMessage *message,
 
     if (!strcmp(ICD_UI_DBUS_SERVICE, name))
       ILOG_WARN("connectivity UI service '" ICD_UI_DBUS_SERVICE "' started");
-    else
-    {
-      struct icd_tracking_info *track = icd_tracking_info_find(name);
-
-      if (track)
-      {
-        ILOG_INFO("application '%s' ('%s') restored", name, new);
-
-        icd_tracking_info_update(track, new, NULL);
-      }
-    }
+    else if (icd_request_tracking_info_rename(name, new))
+      ILOG_INFO("application '%s' ('%s') restored", name, new);
   }
   else
   {
@@ -80,10 +92,22 @@ icd_name_owner_filter(DBusConnection *connection, DBusMessage *message,
           icd_request_cancel(request, ICD_POLICY_ATTRIBUTE_CONN_UI);
       }
     }
-    else if (icd_request_tracking_info_delete(name) ||
-             icd_dbus_api_app_exit(name))
+    else
     {
+      gboolean tracked = FALSE;
+
+      while (icd_request_tracking_info_delete(name))
+        tracked = TRUE;
+
+      if (icd_dbus_api_app_exit(name))
+        tracked = TRUE;
+
+      if (tracked)
         ILOG_INFO("tracked application '%s' ('%s') exited", name, old);
+
+      /* unique names are never reused, so anything still counted for this
+         one would stay in the table forever */
+      g_hash_table_remove(icd_name_owner_get_names(), name);
     }
   }
 
@@ -91,54 +115,78 @@ icd_name_owner_filter(DBusConnection *connection, DBusMessage *message,
 }
 
 /**
- * @brief Add a filter for NameOwnerChanged signals for a specific application
+ * @brief Start tracking NameOwnerChanged signals for a specific application
  *
  * @param application application D-Bus id
  *
- * @return the return status of #icd_dbus_connect_system_bcast_signal
+ * @return TRUE
  *
  */
 gboolean
 icd_name_owner_add_filter(const gchar *application)
 {
-  gchar *filter;
-  gboolean rv;
+  GHashTable *names = icd_name_owner_get_names();
+  gpointer count;
 
-  filter = g_strdup_printf(ICD_NAME_OWNER_FILTER_STRING, application);
-  rv = icd_dbus_connect_system_bcast_signal(DBUS_INTERFACE_DBUS,
-                                            icd_name_owner_filter, NULL,
-                                            filter);
-  g_free(filter);
+  if (!application)
+    return FALSE;
+
+  count = g_hash_table_lookup(names, application);
+
+  if (count)
+  {
+    g_hash_table_insert(names, g_strdup(application),
+                        GUINT_TO_POINTER(GPOINTER_TO_UINT(count) + 1));
+  }
+  else
+    g_hash_table_insert(names, g_strdup(application), GUINT_TO_POINTER(1));
 
-  return rv;
+  return TRUE;
 }
 
 /**
- * @brief Remove a filter for NameOwnerChanged signals for a specific
- * application
+ * @brief Stop tracking NameOwnerChanged signals for a specific application;
+ * the application is tracked until this has been called as many times as
+ * #icd_name_owner_add_filter
  *
  * @param application application D-Bus id
  *
- * @return the return status of #icd_dbus_disconnect_system_bcast_signal
+ * @return TRUE on success, FALSE if the application was not tracked
  *
  */
 gboolean
 icd_name_owner_remove_filter(const gchar *application)
 {
-  gchar *filter;
-  gboolean rv;
+  GHashTable *names = icd_name_owner_get_names();
+  guint count;
+
+  if (!application)
+    return FALSE;
+
+  count = GPOINTER_TO_UINT(g_hash_table_lookup(names, application));
 
-  filter = g_strdup_printf(ICD_NAME_OWNER_FILTER_STRING, application);
-  rv = icd_dbus_disconnect_system_bcast_signal(DBUS_INTERFACE_DBUS,
-                                               icd_name_owner_filter, NULL,
-                                               filter);
-  g_free(filter);
+  if (!count)
+  {
+    ILOG_WARN("application '%s' not tracked for NameOwnerChanged",
+              application);
+    return FALSE;
+  }
+
+  if (count > 1)
+  {
+    g_hash_table_insert(names, g_strdup(application),
+                        GUINT_TO_POINTER(count - 1));
+  }
+  else
+    g_hash_table_remove(names, application);
 
-  return rv;
+  return TRUE;
 }
 
 /**
- * @brief Initialize NameOwnerChanged filtering
+ * @brief Initialize NameOwnerChanged filtering; a single match and filter
+ * are installed for all NameOwnerChanged signals and the filter only handles
+ * the tracked applications
  *
  * @param icd_ctx icd context
  *
@@ -148,5 +196,12 @@ icd_name_owner_remove_filter(const gchar *application)
 gboolean
 icd_name_owner_init(struct icd_context *icd_ctx)
 {
+  if (!icd_dbus_connect_system_bcast_signal(DBUS_INTERFACE_DBUS,
+                                            icd_name_owner_filter, NULL,
+                                            ICD_NAME_OWNER_FILTER_STRING))
+  {
+    return FALSE;
+  }
+
   return icd_name_owner_add_filter(ICD_UI_DBUS_SERVICE);
 }
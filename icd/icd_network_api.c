@@ -12,6 +12,7 @@
 #include "icd_status.h"
 #include "config.h"
 #include "icd_version.h"
+#include "icd_network_priority.h"
 
 /** prefix for the ICd network API modules */
 #define ICD_NW_API_PREFIX   "libicd_network_"
@@ -340,27 +341,172 @@ icd_network_api_renew(enum icd_nw_layer renew_layer, const gchar *network_type,
              icd_iap_state_names[iap->state]);
 }
 
+/**
+ * @brief Find a network type in the network type registry
+ *
+ * @param type the network type
+ *
+ * @return the registry entry or NULL if the network type is not mapped to any
+ * network module
+ *
+ */
+struct icd_network_type *
+icd_network_api_type_get(const gchar *type)
+{
+  struct icd_context *icd_ctx = icd_context_get();
+
+  if (!type || !icd_ctx->nw_type_registry)
+    return NULL;
+
+  return (struct icd_network_type *)
+      g_hash_table_lookup(icd_ctx->nw_type_registry, type);
+}
+
+/**
+ * @brief Find a network type in the network type registry by its id
+ *
+ * @param id the network type id
+ *
+ * @return the registry entry or NULL if the id is not in use
+ *
+ */
+struct icd_network_type *
+icd_network_api_type_get_by_id(const guint id)
+{
+  struct icd_context *icd_ctx = icd_context_get();
+
+  if (id == ICD_NW_TYPE_ID_NONE || !icd_ctx->nw_type_ids ||
+      id >= icd_ctx->nw_type_ids->len)
+  {
+    return NULL;
+  }
+
+  return (struct icd_network_type *)g_ptr_array_index(icd_ctx->nw_type_ids,
+                                                      id);
+}
+
+/**
+ * @brief Get the network type mask of all network types starting with a
+ * prefix
+ *
+ * @param prefix the network type prefix
+ *
+ * @return the network type mask
+ *
+ */
+guint32
+icd_network_api_type_prefix_mask(const gchar *prefix)
+{
+  struct icd_context *icd_ctx = icd_context_get();
+  guint32 mask = 0;
+  guint id;
+
+  if (!prefix || !icd_ctx->nw_type_ids)
+    return 0;
+
+  for (id = 1; id < icd_ctx->nw_type_ids->len; id++)
+  {
+    struct icd_network_type *type = (struct icd_network_type *)
+        g_ptr_array_index(icd_ctx->nw_type_ids, id);
+
+    if (g_str_has_prefix(type->name, prefix))
+      mask |= ICD_NW_TYPE_MASK(id);
+  }
+
+  return mask;
+}
+
+/**
+ * @brief Add a network type to the network type registry
+ *
+ * @param icd_ctx icd context
+ * @param name the network type
+ *
+ * @return the new or already existing registry entry
+ *
+ */
+static struct icd_network_type *
+icd_network_api_type_register(struct icd_context *icd_ctx, const gchar *name)
+{
+  struct icd_network_type *type = icd_network_api_type_get(name);
+
+  if (type)
+    return type;
+
+  type = g_new0(struct icd_network_type, 1);
+  type->name = g_strdup(name);
+  type->priority = icd_network_priority_type(name);
+
+  if (icd_ctx->nw_type_ids->len <= ICD_NW_TYPE_ID_MAX)
+  {
+    type->id = icd_ctx->nw_type_ids->len;
+    g_ptr_array_add(icd_ctx->nw_type_ids, type);
+  }
+  else
+  {
+    ILOG_WARN("network type '%s' does not fit in network type mask", name);
+    type->id = ICD_NW_TYPE_ID_NONE;
+  }
+
+  g_hash_table_insert(icd_ctx->nw_type_registry, type->name, type);
+  ILOG_DEBUG("network type '%s' has id %u", name, type->id);
+
+  return type;
+}
+
+/**
+ * @brief Free a network type registry entry
+ *
+ * @param key network type
+ * @param value the registry entry
+ * @param user_data not used
+ *
+ */
+static void
+icd_network_api_type_free(gpointer key, gpointer value, gpointer user_data)
+{
+  struct icd_network_type *type = (struct icd_network_type *)value;
+
+  g_slist_free(type->srv_module_list);
+  g_free(type->name);
+  g_free(type);
+}
+
+/**
+ * @brief Check whether a network module can search for networks
+ *
+ * @param module the network module
+ *
+ * @return TRUE if the module has a search function, FALSE otherwise
+ *
+ */
+gboolean
+icd_network_api_has_search(struct icd_network_module *module)
+{
+  return module->nw.start_search || module->nw.start_search_batch;
+}
+
 gboolean
 icd_network_api_has_type(struct icd_network_module *module, const gchar *type)
 {
-  struct icd_context *icd_ctx;
+  struct icd_network_type *nw_type;
   GSList *l;
 
   if (!type || !module)
     return FALSE;
 
-  icd_ctx = icd_context_get();
+  nw_type = icd_network_api_type_get(type);
 
-  for (l = (GSList *)g_hash_table_lookup(icd_ctx->type_to_module, type); l;
-       l = l->next)
+  if (!nw_type)
+    return FALSE;
+
+  if (nw_type->id != ICD_NW_TYPE_ID_NONE)
+    return (module->network_type_mask & ICD_NW_TYPE_MASK(nw_type->id)) != 0;
+
+  for (l = module->network_types; l; l = l->next)
   {
-    if (l->data)
-    {
-      if (l->data == module)
-        return TRUE;
-    }
-    else
-      ILOG_CRIT("Module list has NULL type");
+    if (l->data && !strcmp((const gchar *)l->data, type))
+      return TRUE;
   }
 
   return FALSE;
@@ -424,7 +570,7 @@ icd_network_api_init_cb(const gchar *module_name, void *handle,
       goto err_version;
     }
   }
-  else if (module->nw.start_search &&
+  else if (icd_network_api_has_search(module) &&
            module->nw.search_lifetime <= module->nw.search_interval)
   {
     ILOG_ERR("module '%s' search lifetime (%d) must be greater than search interval (%d)",
@@ -433,13 +579,22 @@ icd_network_api_init_cb(const gchar *module_name, void *handle,
     goto err_version;
   }
 
+  if (icd_version_compare(module->nw.version, "0.89") < 0 &&
+      module->nw.start_search_batch)
+  {
+    ILOG_ERR("module '%s' version %s compiled against API < 0.89, not loading it",
+             module_name, module->nw.version);
+    goto err_version;
+  }
+
   ILOG_DEBUG("Network module %p '%s' version %s", module, module_name,
              module->nw.version);
 
   module->name = g_strdup(module_name);
   icd_ctx->nw_module_list = g_slist_prepend(icd_ctx->nw_module_list, module);
+  module->nw.search_cb_threaded = icd_scan_cb_threaded;
 
-  if (module->nw.start_search)
+  if (icd_network_api_has_search(module))
     icd_scan_cache_init(module);
 
   return TRUE;
@@ -464,6 +619,7 @@ icd_network_api_load_modules(struct icd_context *icd_ctx)
   GSList *modules;
   GConfClient *gconf;
   GSList *dirs;
+  GSList *l;
   gchar *dir;
   gboolean rv = FALSE;
   GError *err = NULL;
@@ -476,6 +632,10 @@ icd_network_api_load_modules(struct icd_context *icd_ctx)
 
   icd_ctx->type_to_module =
       g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  icd_ctx->nw_type_registry = g_hash_table_new(g_str_hash, g_str_equal);
+  icd_ctx->nw_type_ids = g_ptr_array_new();
+  /* id 0 is ICD_NW_TYPE_ID_NONE */
+  g_ptr_array_add(icd_ctx->nw_type_ids, NULL);
   gconf = gconf_client_get_default();
   dirs = gconf_client_all_dirs(gconf, ICD_GCONF_NETWORK_MAPPING, &err);
 
@@ -545,6 +705,8 @@ icd_network_api_load_modules(struct icd_context *icd_ctx)
       if (all_found)
       {
         GSList *tmpl = type_to_module;
+        struct icd_network_type *type =
+            icd_network_api_type_register(icd_ctx, network_type);
 
         g_hash_table_insert(icd_ctx->type_to_module, g_strdup(network_type),
                             type_to_module);
@@ -556,6 +718,7 @@ icd_network_api_load_modules(struct icd_context *icd_ctx)
 
           mod->network_types = g_slist_prepend(mod->network_types,
                                                g_strdup(network_type));
+          mod->network_type_mask |= ICD_NW_TYPE_MASK(type->id);
           tmpl = tmpl->next;
         }
 
@@ -577,6 +740,15 @@ icd_network_api_load_modules(struct icd_context *icd_ctx)
   if (!rv)
     goto err_out;
 
+  /* restored entries need the network types and their ids */
+  for (l = icd_ctx->nw_module_list; l; l = l->next)
+  {
+    struct icd_network_module *module = (struct icd_network_module *)l->data;
+
+    if (module && icd_network_api_has_search(module))
+      icd_scan_cache_restore(module);
+  }
+
   return rv;
 
 err_out:
@@ -631,4 +803,18 @@ icd_network_api_unload_modules(struct icd_context *icd_ctx)
 
   if (icd_ctx->type_to_module)
     g_hash_table_destroy(icd_ctx->type_to_module);
+
+  if (icd_ctx->nw_type_registry)
+  {
+    g_hash_table_foreach(icd_ctx->nw_type_registry, icd_network_api_type_free,
+                         NULL);
+    g_hash_table_destroy(icd_ctx->nw_type_registry);
+    icd_ctx->nw_type_registry = NULL;
+  }
+
+  if (icd_ctx->nw_type_ids)
+  {
+    g_ptr_array_free(icd_ctx->nw_type_ids, TRUE);
+    icd_ctx->nw_type_ids = NULL;
+  }
 }
@@ -6,18 +6,65 @@
 #include "network_api.h"
 #include "icd_context.h"
 
+/** network type id of a type without an id in the registry */
+#define ICD_NW_TYPE_ID_NONE   0
+
+/** number of network type ids that fit in a network type mask */
+#define ICD_NW_TYPE_ID_MAX   32
+
+/** network type mask bit for a network type id */
+#define ICD_NW_TYPE_MASK(id)   ((id) ? (guint32)1 << ((id) - 1) : 0)
+
+/** network type registry entry, created for each network type mapped to
+ * network modules */
+struct icd_network_type {
+  /** network type */
+  gchar *name;
+
+  /** small integer id of the network type or #ICD_NW_TYPE_ID_NONE if more
+   * than #ICD_NW_TYPE_ID_MAX network types are in use */
+  guint id;
+
+  /** network priority of the type, see #icd_network_priority_type */
+  gint priority;
+
+  /** #icd_srv_module service provider modules for this network type */
+  GSList *srv_module_list;
+};
+
 struct icd_network_module {
   void *handle;
   gchar *name;
   GSList *network_types;
+  guint32 network_type_mask;
   GSList *pid_list;
 
   guint scope;
   gboolean scan_progress;
+  gboolean scan_targeted;
+  gchar *scan_target_id;
+  gboolean scan_full_pending;
   gint scan_timeout_rescan;
-  GSList *scan_timeout_list;
+  guint scan_interval;
+  guint scan_interval_max;
+  guint scan_last_complete;
+  guint scan_snapshot_saved;
+  guint scan_churn;
+  gint scan_db_hysteresis;
+  guint scan_notify_interval;
+  guint scan_cache_max;
+  gint scan_timeout_expire;
+  GQueue *scan_expire_queue;
   GHashTable *scan_cache_table;
+  GHashTable *scan_cache_id_table;
+  /** #ICD_NW_ATTR_IAPNAME entries by IAP name */
+  GHashTable *scan_cache_iap_table;
+  /** entries by station id */
+  GHashTable *scan_cache_station_table;
   GSList *scan_listener_list;
+  /** listeners by network type id; listeners for all network types are
+   *  in the #ICD_NW_TYPE_ID_NONE bucket */
+  GSList *scan_listener_dispatch[ICD_NW_TYPE_ID_MAX + 1];
 
   struct icd_nw_api nw;
 };
@@ -38,6 +85,10 @@ typedef gboolean
 
 gboolean icd_network_api_has_type (struct icd_network_module *module,
                                    const gchar *type);
+gboolean icd_network_api_has_search (struct icd_network_module *module);
+struct icd_network_type *icd_network_api_type_get (const gchar *type);
+struct icd_network_type *icd_network_api_type_get_by_id (const guint id);
+guint32 icd_network_api_type_prefix_mask (const gchar *prefix);
 struct icd_network_module *
 icd_network_api_foreach_module (struct icd_context *icd_ctx,
                                 icd_network_api_foreach_module_fn foreach_fn,
@@ -4,6 +4,7 @@
 #include "icd_log.h"
 #include "icd_network_priority.h"
 #include "network_api.h"
+#include "icd_network_api.h"
 
 /**  preferred service network priority */
 #define ICD_NW_PRIO_SRV_PREF   500
@@ -85,10 +86,43 @@ icd_network_priority_pref_init (void)
              preferred_id);
 }
 
+/**
+ * @brief Get the network priority of a network type; used when building the
+ * network type registry
+ *
+ * @param network_type the network type
+ *
+ * @return the network priority of the type
+ *
+ */
+gint
+icd_network_priority_type(const gchar *network_type)
+{
+  if (!strncmp(network_type, ICD_NW_TYPE_WLAN, strlen(ICD_NW_TYPE_WLAN)))
+    return ICD_NW_PRIO_WLAN;
+  else if (!strcmp(network_type, ICD_NW_TYPE_WIMAX))
+    return ICD_NW_PRIO_WIMAX;
+  else if (!strcmp(network_type, ICD_NW_TYPE_DUN_GSM_PS) ||
+           !strcmp(network_type, ICD_NW_TYPE_DUN_CDMA_PSD))
+  {
+    return ICD_NW_PRIO_DUN_PS;
+  }
+  else if (!strcmp(network_type, ICD_NW_TYPE_DUN_GSM_CS) ||
+           !strcmp(network_type, ICD_NW_TYPE_DUN_CDMA_CSD))
+  {
+    return ICD_NW_PRIO_DUN_CS;
+  }
+  else if (!strcmp(network_type, ICD_NW_TYPE_DUN_CDMA_QNC))
+    return ICD_NW_PRIO_DUN_CS;
+
+  return 0;
+}
+
 gint
 icd_network_priority_get(const gchar *srv_type, const gchar *srv_id,
                          const gchar *network_type, const guint network_attrs)
 {
+  struct icd_network_type *type;
   guint priority = 0;
 
   if (preferred_id && preferred_type && srv_type && srv_id &&
@@ -100,22 +134,12 @@ icd_network_priority_get(const gchar *srv_type, const gchar *srv_id,
   if (network_attrs & ICD_NW_ATTR_IAPNAME)
     priority = ICD_NW_PRIO_SAVED_BOOSTER_VALUE;
 
-  if (!strncmp(network_type, ICD_NW_TYPE_WLAN, strlen(ICD_NW_TYPE_WLAN)))
-    priority += ICD_NW_PRIO_WLAN;
-  else if (!strcmp(network_type, ICD_NW_TYPE_WIMAX))
-    priority += ICD_NW_PRIO_WIMAX;
-  else if (!strcmp(network_type, ICD_NW_TYPE_DUN_GSM_PS) ||
-           !strcmp(network_type, ICD_NW_TYPE_DUN_CDMA_PSD))
-  {
-    priority += ICD_NW_PRIO_DUN_PS;
-  }
-  else if (!strcmp(network_type, ICD_NW_TYPE_DUN_GSM_CS) ||
-           !strcmp(network_type, ICD_NW_TYPE_DUN_CDMA_CSD))
-  {
-    priority += ICD_NW_PRIO_DUN_CS;
-  }
-  else if (!strcmp(network_type, ICD_NW_TYPE_DUN_CDMA_QNC))
-    priority += ICD_NW_PRIO_DUN_CS;
+  type = icd_network_api_type_get(network_type);
+
+  if (type)
+    priority += type->priority;
+  else
+    priority += icd_network_priority_type(network_type);
 
   return priority;
 }
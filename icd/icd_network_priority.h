@@ -6,6 +6,8 @@
 
 void icd_network_priority_pref_init (void);
 
+gint icd_network_priority_type (const gchar *network_type);
+
 gint icd_network_priority_get (const gchar *srv_type,
                                const gchar *srv_id,
                                const gchar *network_type,
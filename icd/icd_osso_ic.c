@@ -17,6 +17,7 @@
 #include "icd_tracking_info.h"
 #include "icd_status.h"
 #include "icd_wlan_defs.h"
+#include "icd_dbus_dispatch.h"
 
 /** milliseconds to wait for UI to respond to requests; used only for log
  * message printing for now
@@ -207,7 +208,6 @@ static DBusMessage *
 icd_osso_ic_bg_killed(DBusMessage *method_call, void *user_data)
 {
   gchar *s;
-  struct icd_tracking_info *track;
   const gchar *sender;
   const gchar *application;
 
@@ -217,14 +217,9 @@ icd_osso_ic_bg_killed(DBusMessage *method_call, void *user_data)
                         DBUS_TYPE_INVALID);
 
   s = g_strdup_printf("com.nokia.%s", application);
-  track = icd_tracking_info_find(sender);
 
-  if (track)
-  {
+  if (icd_request_tracking_info_rename(sender, s))
     ILOG_INFO("application '%s' ('%s') background killed", application, sender);
-
-    icd_tracking_info_update(track, s, NULL);
-  }
   else
   {
     ILOG_DEBUG("application '%s' ('%s') background killed but not tracked",
@@ -1119,45 +1114,90 @@ static struct icd_osso_ic_handler icd_osso_ui_htable[] = {
   {NULL}
 };
 
-static icd_osso_ic_message_handler
-icd_osso_ic_find_handler(DBusMessage *msg, struct icd_osso_ic_handler *handlers)
+/** dispatch tables for OSSO IC method calls and UI signals */
+struct icd_osso_ic_dispatch {
+  /** OSSO IC API method calls */
+  struct icd_dbus_dispatch *ic;
+
+  /** UI signals */
+  struct icd_dbus_dispatch *ui;
+};
+
+/**
+ * @brief Get the OSSO IC dispatch tables
+ *
+ * @return the dispatch tables
+ *
+ */
+static struct icd_osso_ic_dispatch *
+icd_osso_ic_dispatch_get(void)
 {
-  const char *iface = dbus_message_get_interface(msg);
-  const char *member = dbus_message_get_member(msg);
+  static struct icd_osso_ic_dispatch dispatch = {NULL, NULL};
 
-  while (handlers->interface)
-  {
-    if (!strcmp(iface, handlers->interface) &&
-        !strcmp(member, handlers->method) &&
-        (!handlers->signature ||
-         dbus_message_has_signature(msg, handlers->signature)))
-    {
-      return handlers->handler;
-    }
+  return &dispatch;
+}
+
+/**
+ * @brief Create a dispatch table from a handler array
+ *
+ * @param name name of the dispatch table
+ * @param handlers NULL terminated handler array
+ *
+ * @return the dispatch table
+ *
+ */
+static struct icd_dbus_dispatch *
+icd_osso_ic_dispatch_new(const gchar *name,
+                         const struct icd_osso_ic_handler *handlers)
+{
+  struct icd_dbus_dispatch *dispatch = icd_dbus_dispatch_new(name);
 
-    handlers++;
+  for (; handlers->interface; handlers++)
+  {
+    icd_dbus_dispatch_add(dispatch, handlers->interface, handlers->method,
+                          handlers->signature, handlers->handler);
   }
 
-  return NULL;
+  return dispatch;
+}
+
+/**
+ * @brief Free the OSSO IC dispatch tables
+ *
+ */
+static void
+icd_osso_ic_dispatch_free(void)
+{
+  struct icd_osso_ic_dispatch *dispatch = icd_osso_ic_dispatch_get();
+
+  icd_dbus_dispatch_free(dispatch->ic);
+  dispatch->ic = NULL;
+  icd_dbus_dispatch_free(dispatch->ui);
+  dispatch->ui = NULL;
 }
 
 static DBusHandlerResult
 icd_osso_ic_request(DBusConnection *connection, DBusMessage *message,
                     void *user_data)
 {
+  struct icd_dbus_dispatch_entry *entry;
   icd_osso_ic_message_handler handler;
   DBusMessage *msg;
+  gint64 start;
 
-  handler = icd_osso_ic_find_handler(message, icd_osso_ic_htable);
+  entry = icd_dbus_dispatch_find(icd_osso_ic_dispatch_get()->ic, message);
 
-  if (handler)
+  if (entry)
   {
     ILOG_INFO("Received %s.%s (%s) request",
               dbus_message_get_interface(message),
               dbus_message_get_member(message),
               dbus_message_get_signature(message));
 
+    handler = (icd_osso_ic_message_handler)entry->handler;
+    start = g_get_monotonic_time();
     msg = handler(message, user_data);
+    icd_dbus_dispatch_done(entry, start);
   }
   else
   {
@@ -1184,19 +1224,27 @@ icd_osso_ui_signal(DBusConnection *connection, DBusMessage *message,
 {
   if (dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_SIGNAL)
   {
-    if (!strcmp(ICD_UI_DBUS_INTERFACE, dbus_message_get_interface(message)))
+    const char *iface = dbus_message_get_interface(message);
+
+    if (iface && !strcmp(ICD_UI_DBUS_INTERFACE, iface))
     {
-      icd_osso_ic_message_handler handler =
-          icd_osso_ic_find_handler(message, icd_osso_ui_htable);
+      struct icd_dbus_dispatch_entry *entry =
+          icd_dbus_dispatch_find(icd_osso_ic_dispatch_get()->ui, message);
 
-      if (handler)
+      if (entry)
       {
+        icd_osso_ic_message_handler handler =
+            (icd_osso_ic_message_handler)entry->handler;
+        gint64 start;
+
         ILOG_INFO("received '%s.%s' (%s) signal from UI",
                   dbus_message_get_interface(message),
                   dbus_message_get_member(message),
                   dbus_message_get_signature(message));
 
+        start = g_get_monotonic_time();
         handler(message, user_data);
+        icd_dbus_dispatch_done(entry, start);
       }
       else
       {
@@ -1214,6 +1262,13 @@ icd_osso_ui_signal(DBusConnection *connection, DBusMessage *message,
 gboolean
 icd_osso_ic_init(struct icd_context *icd_ctx)
 {
+  struct icd_osso_ic_dispatch *dispatch = icd_osso_ic_dispatch_get();
+
+  dispatch->ic = icd_osso_ic_dispatch_new(ICD_DBUS_INTERFACE,
+                                          icd_osso_ic_htable);
+  dispatch->ui = icd_osso_ic_dispatch_new(ICD_UI_DBUS_INTERFACE,
+                                          icd_osso_ui_htable);
+
   if (!icd_dbus_register_system_service(ICD_DBUS_PATH,
                                         ICD_DBUS_SERVICE,
                                         DBUS_NAME_FLAG_REPLACE_EXISTING |
@@ -1222,6 +1277,7 @@ icd_osso_ic_init(struct icd_context *icd_ctx)
                                         NULL))
   {
     ILOG_CRIT("could not register '" ICD_DBUS_SERVICE "'");
+    icd_osso_ic_dispatch_free();
     return FALSE;
   }
 
@@ -1234,6 +1290,7 @@ icd_osso_ic_init(struct icd_context *icd_ctx)
 
     icd_dbus_unregister_system_service(ICD_DBUS_PATH,
                                        ICD_DBUS_SERVICE);
+    icd_osso_ic_dispatch_free();
     return FALSE;
   }
 
@@ -1248,6 +1305,7 @@ icd_osso_ic_deinit(void)
   icd_dbus_unregister_system_service(ICD_DBUS_PATH, ICD_DBUS_SERVICE);
   icd_dbus_disconnect_system_bcast_signal(ICD_UI_DBUS_INTERFACE,
                                           icd_osso_ui_signal, NULL, NULL);
+  icd_osso_ic_dispatch_free();
 }
 
 void
@@ -604,7 +604,9 @@ icd_policy_api_scan_start(const gchar *type, const guint scope,
   data->user_data = user_data;
   *scan_list = g_slist_prepend(*scan_list, data);
 
-  if (!icd_scan_results_request(type, scope, icd_policy_api_scan_result, data))
+  /* connecting can use the results of a scan completed moments ago */
+  if (!icd_scan_results_request_filtered(type, scope, NULL, TRUE,
+                                         icd_policy_api_scan_result, data))
   {
     ILOG_DEBUG("policy api scan did not find anything to scan, freeing...");
 
@@ -1,4 +1,5 @@
 #include <string.h>
+#include <time.h>
 #include <osso-ic.h>
 #include <osso-ic-dbus.h>
 #include "icd_request.h"
@@ -14,9 +15,17 @@
 #include "icd_dbus_api.h"
 #include "icd_name_owner.h"
 #include "icd_network_priority.h"
+#include "icd_scan.h"
+#include "icd_string.h"
 
 static void icd_request_try_iap_cb(enum icd_iap_status status,
                                    struct icd_iap *iap, gpointer user_data);
+static void icd_request_connect(struct icd_request *request);
+static void
+icd_request_scan_probe_cb(enum icd_scan_status status,
+                          const struct icd_scan_srv_provider *srv_provider,
+                          const struct icd_scan_cache *cache_entry,
+                          gpointer user_data);
 
 /** ICd request status names */
 static const gchar *icd_request_status_names[ICD_REQUEST_MAX] = {
@@ -30,28 +39,6 @@ static const gchar *icd_request_status_names[ICD_REQUEST_MAX] = {
   "ICD_REQUEST_DISCONNECTED"
 };
 
-/**
- * @brief Helper function for comparing two strings where a NULL string is equal
- * to another NULL string
- *
- * @param a string A
- * @param b string B
- *
- * @return TRUE if equal, FALSE if unequal
- *
- */
-inline static gboolean
-icd_request_string_equal(const char *a, const char *b)
-{
-  if (!a)
-    return !b;
-
-  if (b)
-    return !strcmp(a, b);
-
-  return FALSE;
-}
-
 /**
  * @brief Foreach function for network finding
  *
@@ -70,8 +57,8 @@ icd_request_find_foreach(struct icd_request *request, gpointer user_data)
 
   if (((pattrs & ICD_NW_ATTR_IAPNAME) == (attrs & ICD_NW_ATTR_IAPNAME)) &&
       ((attrs & ICD_NW_ATTR_LOCALMASK) == (pattrs & ICD_NW_ATTR_LOCALMASK)) &&
-      icd_request_string_equal(request->req.network_type, preq->network_type) &&
-      icd_request_string_equal(request->req.network_id, preq->network_id) )
+      icd_string_equal(request->req.network_type, preq->network_type) &&
+      icd_string_equal(request->req.network_id, preq->network_id) )
   {
 
     ILOG_DEBUG("found request %p with %s/%0x/%s", request, preq->network_type,
@@ -83,6 +70,132 @@ icd_request_find_foreach(struct icd_request *request, gpointer user_data)
   return NULL;
 }
 
+/**
+ * @brief Get the index of requests by the D-Bus senders tracked in them
+ *
+ * @return hash table of sender to a list of requests
+ *
+ */
+static GHashTable *
+icd_request_sender_index_get(void)
+{
+  static GHashTable *index = NULL;
+
+  if (!index)
+    index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+  return index;
+}
+
+/**
+ * @brief Index a request with a D-Bus sender tracked in it
+ *
+ * @param request the request
+ * @param sender the D-Bus sender
+ *
+ */
+static void
+icd_request_sender_index_add(struct icd_request *request, const gchar *sender)
+{
+  GHashTable *index = icd_request_sender_index_get();
+  GSList *requests;
+
+  if (!sender)
+    return;
+
+  requests = (GSList *)g_hash_table_lookup(index, sender);
+
+  if (g_slist_find(requests, request))
+    return;
+
+  g_hash_table_insert(index, g_strdup(sender),
+                      g_slist_prepend(requests, request));
+  request->senders = g_slist_prepend(request->senders, g_strdup(sender));
+}
+
+/**
+ * @brief Remove one D-Bus sender of a request from the sender index
+ *
+ * @param request the request
+ * @param sender the D-Bus sender
+ *
+ */
+static void
+icd_request_sender_index_remove_sender(struct icd_request *request,
+                                       const gchar *sender)
+{
+  GHashTable *index = icd_request_sender_index_get();
+  GSList *l = g_slist_find_custom(request->senders, sender,
+                                  (GCompareFunc)strcmp);
+  GSList *requests;
+
+  if (!l)
+    return;
+
+  requests = (GSList *)g_hash_table_lookup(index, sender);
+  requests = g_slist_remove(requests, request);
+
+  if (requests)
+    g_hash_table_insert(index, g_strdup(sender), requests);
+  else
+    g_hash_table_remove(index, sender);
+
+  g_free(l->data);
+  request->senders = g_slist_delete_link(request->senders, l);
+}
+
+/**
+ * @brief Remove a request from the sender index
+ *
+ * @param request the request
+ *
+ */
+static void
+icd_request_sender_index_remove(struct icd_request *request)
+{
+  while (request->senders)
+  {
+    icd_request_sender_index_remove_sender(
+          request, (const gchar *)request->senders->data);
+  }
+}
+
+/**
+ * @brief Call the user given function for each request that has tracked the
+ * D-Bus sender; the sender may no longer be among the users of the request
+ *
+ * @param sender the D-Bus sender
+ * @param fn the function
+ * @param user_data user data to pass to the function
+ *
+ * @return the pointer returned from the user function
+ *
+ */
+gpointer
+icd_request_foreach_sender(const gchar *sender, icd_request_foreach_fn fn,
+                           gpointer user_data)
+{
+  GSList *l;
+
+  if (!fn || !sender)
+  {
+    ILOG_ERR("no foreach request function or sender");
+    return NULL;
+  }
+
+  l = (GSList *)g_hash_table_lookup(icd_request_sender_index_get(), sender);
+
+  for (; l; l = l->next)
+  {
+    gpointer rv = fn((struct icd_request *)l->data, user_data);
+
+    if (rv)
+      return rv;
+  }
+
+  return NULL;
+}
+
 /**
  * @brief Iterate over all requests and call the user given function for each
  * of them
@@ -204,25 +317,299 @@ icd_request_tracking_info_delete(const gchar *sender)
     return FALSE;
   }
 
-  return icd_request_foreach(
-        icd_request_tracking_info_delete_foreach, (gpointer)sender) != NULL;
+  return icd_request_foreach_sender(
+        sender, icd_request_tracking_info_delete_foreach,
+        (gpointer)sender) != NULL;
+}
+
+/** old and new sender for #icd_request_tracking_info_rename_foreach */
+struct icd_request_rename_data {
+  /** the old D-Bus sender */
+  const gchar *sender;
+  /** the new D-Bus sender */
+  const gchar *new_sender;
+  /** requests in which tracking info was renamed */
+  GSList *renamed;
+};
+
+/**
+ * @brief Iterator function for renaming a D-Bus sender
+ *
+ * @param request the request
+ * @param user_data #icd_request_rename_data
+ *
+ * @return NULL to go through all requests
+ *
+ */
+static gpointer
+icd_request_tracking_info_rename_foreach(struct icd_request *request,
+                                         gpointer user_data)
+{
+  struct icd_request_rename_data *rename =
+      (struct icd_request_rename_data *)user_data;
+  GSList *l;
+
+  for (l = request->users; l; l = l->next)
+  {
+    struct icd_tracking_info *track = (struct icd_tracking_info *)l->data;
+
+    if (track && track->sender && !strcmp(track->sender, rename->sender))
+    {
+      icd_tracking_info_update(track, rename->new_sender, NULL);
+      icd_request_sender_index_add(request, rename->new_sender);
+      icd_name_owner_remove_filter(rename->sender);
+      icd_name_owner_add_filter(rename->new_sender);
+
+      if (!g_slist_find(rename->renamed, request))
+        rename->renamed = g_slist_prepend(rename->renamed, request);
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Change the D-Bus sender of tracked users, e.g. when an application
+ * with a well-known name is restarted or is background killed; the requests
+ * are indexed and NameOwnerChanged is tracked with the new sender
+ *
+ * @param sender the old D-Bus sender
+ * @param new_sender the new D-Bus sender
+ *
+ * @return TRUE if any tracked user was changed, FALSE otherwise
+ *
+ */
+gboolean
+icd_request_tracking_info_rename(const gchar *sender, const gchar *new_sender)
+{
+  struct icd_request_rename_data rename;
+  GSList *l;
+
+  if (!sender || !new_sender)
+  {
+    ILOG_ERR("sender NULL when renaming in request");
+    return FALSE;
+  }
+
+  if (!strcmp(sender, new_sender))
+    return FALSE;
+
+  rename.sender = sender;
+  rename.new_sender = new_sender;
+  rename.renamed = NULL;
+
+  icd_request_foreach_sender(sender, icd_request_tracking_info_rename_foreach,
+                             &rename);
+
+  /* all users with the old sender were renamed, the index is changed after
+     iterating over it */
+  for (l = rename.renamed; l; l = l->next)
+  {
+    icd_request_sender_index_remove_sender((struct icd_request *)l->data,
+                                           sender);
+  }
+
+  if (!rename.renamed)
+    return FALSE;
+
+  g_slist_free(rename.renamed);
+
+  return TRUE;
+}
+
+/**
+ * @brief Stop tracking NameOwnerChanged for the users of a request that are
+ * about to be freed
+ *
+ * @param users list of #icd_tracking_info
+ * @param icd2_only only the users of the ICd2 D-Bus API
+ *
+ */
+static void
+icd_request_tracking_info_unwatch(GSList *users, const gboolean icd2_only)
+{
+  GSList *l;
+
+  for (l = users; l; l = l->next)
+  {
+    struct icd_tracking_info *track = (struct icd_tracking_info *)l->data;
+
+    if (track && (!icd2_only || track->interface == ICD_TRACKING_INFO_ICD2))
+      icd_name_owner_remove_filter(track->sender);
+  }
 }
 
 void
 icd_request_send_nack(struct icd_request *request)
 {
+  icd_request_tracking_info_unwatch(request->users, FALSE);
   icd_osso_ic_send_nack(request->users);
   icd_dbus_api_send_nack(request->users, NULL);
   g_slist_free(request->users);
   request->users = NULL;
 }
 
+/**
+ * @brief Stop searching for the network of the first IAP
+ *
+ * @param request the request
+ *
+ */
+static void
+icd_request_scan_probe_stop(struct icd_request *request)
+{
+  if (request->scan_probe_idle)
+  {
+    g_source_remove(request->scan_probe_idle);
+    request->scan_probe_idle = 0;
+  }
+
+  if (request->scan_probe)
+  {
+    icd_scan_results_unregister(icd_request_scan_probe_cb, request);
+    request->scan_probe = FALSE;
+  }
+}
+
+/**
+ * @brief Connect the first IAP if its network was found, otherwise go on
+ * with the next IAP
+ *
+ * @param user_data the request
+ *
+ * @return FALSE to remove the idle source
+ *
+ */
+static gboolean
+icd_request_scan_probe_done(gpointer user_data)
+{
+  struct icd_request *request = (struct icd_request *)user_data;
+  struct icd_iap *iap = (struct icd_iap *)request->try_iaps->data;
+
+  request->scan_probe_idle = 0;
+  icd_request_scan_probe_stop(request);
+
+  if (request->scan_probe_found)
+  {
+    icd_status_connect(iap, NULL, NULL);
+    icd_iap_connect(iap, icd_request_try_iap_cb, request);
+  }
+  else
+  {
+    ILOG_INFO("network '%s' of iap %p not found, not connecting it",
+              iap->connection.network_id, iap);
+    request->try_iaps = g_slist_remove(request->try_iaps, iap);
+    icd_iap_free(iap);
+    icd_request_connect(request);
+  }
+
+  return FALSE;
+}
+
+/**
+ * @brief Receive the results of the search for the network of the first IAP;
+ * the search ends as soon as the network is seen or the scan completes
+ *
+ * @param status status of the network
+ * @param srv_provider service provider entry or NULL
+ * @param cache_entry the network
+ * @param user_data the request
+ *
+ */
+static void
+icd_request_scan_probe_cb(enum icd_scan_status status,
+                          const struct icd_scan_srv_provider *srv_provider,
+                          const struct icd_scan_cache *cache_entry,
+                          gpointer user_data)
+{
+  struct icd_request *request = (struct icd_request *)user_data;
+  struct icd_iap *iap = (struct icd_iap *)request->try_iaps->data;
+
+  if (status == ICD_SCAN_EXPIRE)
+    return;
+
+  /* networks replayed from the scan cache were not seen by this search */
+  if (status != ICD_SCAN_COMPLETE)
+  {
+    if (cache_entry->last_seen < request->scan_probe_started ||
+        !icd_string_equal(cache_entry->network_type,
+                          iap->connection.network_type) ||
+        !icd_string_equal(cache_entry->network_id,
+                          iap->connection.network_id))
+    {
+      return;
+    }
+
+    request->scan_probe_found = TRUE;
+  }
+
+  /* the listener cannot be removed while scan results are being sent */
+  if (!request->scan_probe_idle)
+    request->scan_probe_idle = g_idle_add(icd_request_scan_probe_done, request);
+}
+
+/**
+ * @brief Search for the network of a saved IAP before connecting it, if the
+ * network module can search for a single network and the network was not
+ * seen by a scan moments ago
+ *
+ * @param request the request
+ * @param iap the first IAP of the request
+ *
+ * @return TRUE if the search was started and the IAP is connected when it
+ * ends, FALSE if the IAP is to be connected right away
+ *
+ */
+static gboolean
+icd_request_scan_probe(struct icd_request *request, struct icd_iap *iap)
+{
+  struct icd_scan_filter filter;
+
+  if (!(iap->connection.network_attrs & ICD_NW_ATTR_IAPNAME) ||
+      !iap->connection.network_id ||
+      !icd_scan_network_id_supported(iap->connection.network_type))
+  {
+    return FALSE;
+  }
+
+  if (!icd_gconf_agressive_scanning() &&
+      icd_scan_cache_network_is_fresh(iap->connection.network_type,
+                                      iap->connection.network_id))
+  {
+    ILOG_DEBUG("network '%s' of iap %p is fresh in the scan cache",
+               iap->connection.network_id, iap);
+    return FALSE;
+  }
+
+  memset(&filter, 0, sizeof(filter));
+  filter.network_id = iap->connection.network_id;
+
+  ILOG_DEBUG("searching for network '%s' of iap %p before connecting",
+             iap->connection.network_id, iap);
+
+  request->scan_probe = TRUE;
+  request->scan_probe_found = FALSE;
+  request->scan_probe_started = time(NULL);
+
+  if (!icd_scan_results_request_filtered(iap->connection.network_type,
+                                         ICD_NW_SEARCH_SCOPE_SAVED, &filter,
+                                         FALSE, icd_request_scan_probe_cb,
+                                         request))
+  {
+    request->scan_probe = FALSE;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 static void
 icd_request_free(struct icd_request *request)
 {
   struct icd_context *icd_ctx = icd_context_get();
 
   icd_ctx->request_list = g_slist_remove(icd_ctx->request_list, request);
+  icd_request_scan_probe_stop(request);
 
   if (request->try_iaps)
     ILOG_CRIT("Request %p still has IAPs when free called", request);
@@ -233,6 +620,8 @@ icd_request_free(struct icd_request *request)
               request);
   }
 
+  icd_request_sender_index_remove(request);
+
   g_free(request->req.service_type);
   g_free(request->req.service_id);
   g_free(request->req.network_type);
@@ -273,6 +662,14 @@ icd_request_cancel(struct icd_request *request, guint policy_attrs)
 {
   struct icd_context *icd_ctx = icd_context_get();
 
+  if (request->scan_probe)
+  {
+    /* the IAP is not being connected yet */
+    icd_request_scan_probe_stop(request);
+    icd_request_send_nack(request);
+    goto free_request;
+  }
+
   if (request->try_iaps)
   {
     if (request->state && request->state != ICD_REQUEST_WAITING)
@@ -315,6 +712,7 @@ cancel_policy_req:
     icd_policy_api_request_cancel(&request->req);
   }
 
+free_request:
   icd_request_free_iaps(request);
   icd_request_update_status(ICD_REQUEST_DENIED, request);
 
@@ -330,6 +728,7 @@ icd_request_tracking_info_add(struct icd_request *request,
   if (request && track)
   {
     request->users = g_slist_prepend(request->users, track);
+    icd_request_sender_index_add(request, track->sender);
     icd_name_owner_add_filter(track->sender);
 
     ILOG_DEBUG("tracking info sender '%s' and message %p added to request %p",
@@ -384,6 +783,9 @@ icd_request_try_iap(struct icd_request *request)
     if (iap &&
         icd_policy_api_iap_connect(&iap->connection) == ICD_POLICY_ACCEPTED)
     {
+      if (icd_request_scan_probe(request, iap))
+        return TRUE;
+
       icd_status_connect(iap, NULL, NULL);
       icd_iap_connect((struct icd_iap *)request->try_iaps->data,
                       icd_request_try_iap_cb, request);
@@ -494,6 +896,8 @@ icd_request_tracking_info_free(struct icd_request *request)
 {
   GSList *l;
 
+  icd_request_tracking_info_unwatch(request->users, FALSE);
+
   for (l = request->users; l; l = l->next)
     icd_tracking_info_free((struct icd_tracking_info *)l->data);
 
@@ -559,7 +963,11 @@ icd_request_send_ack(struct icd_request *request, struct icd_iap *iap)
   icd_osso_ic_send_ack(request->users, iap->connection.network_id);
 
   if (request->state == ICD_REQUEST_DISCONNECTED)
+  {
+    /* the nack frees the ICd2 D-Bus API users */
+    icd_request_tracking_info_unwatch(request->users, TRUE);
     icd_dbus_api_send_nack(request->users, iap);
+  }
   else
     icd_dbus_api_send_ack(request->users, iap);
 }
@@ -783,8 +1191,11 @@ void
 icd_request_tracking_info_remove(struct icd_request *request,
                                  struct icd_tracking_info *track)
 {
-  if (request && track)
+  if (request && track && g_slist_find(request->users, track))
+  {
     request->users = g_slist_remove_all(request->users, track);
+    icd_name_owner_remove_filter(track->sender);
+  }
 }
 
 gboolean
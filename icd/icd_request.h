@@ -61,6 +61,10 @@ struct icd_request {
   /** list of requesting D-Bus clients */
   GSList *users;
 
+  /** D-Bus senders this request is indexed with, see
+      #icd_request_foreach_sender() */
+  GSList *senders;
+
   /** wheter more than one iap is to be tried, used if none of the IAPs are
       successfully connected
   */
@@ -69,6 +73,19 @@ struct icd_request {
   /** List of IAPs to try */
   GSList *try_iaps;
 
+  /** whether the network of the first IAP is being searched for before
+      connecting it */
+  gboolean scan_probe;
+
+  /** whether the searched for network was seen by the search */
+  gboolean scan_probe_found;
+
+  /** time when the search started */
+  guint scan_probe_started;
+
+  /** idle source that ends the search */
+  guint scan_probe_idle;
+
   /** what this request is all about */
   struct icd_policy_request req;
 };
@@ -88,6 +105,9 @@ typedef gpointer (*icd_request_foreach_fn) (struct icd_request *request,
 
 gpointer icd_request_foreach (icd_request_foreach_fn fn,
                               gpointer user_data);
+gpointer icd_request_foreach_sender (const gchar *sender,
+                                     icd_request_foreach_fn fn,
+                                     gpointer user_data);
 void icd_request_free_iaps (struct icd_request *request);
 struct icd_request *icd_request_find (const gchar *network_type,
                                       const guint network_attrs,
@@ -122,6 +142,8 @@ void icd_request_cancel (struct icd_request *request, guint policy_attrs);
 void icd_request_tracking_info_remove (struct icd_request *request,
                                        struct icd_tracking_info *track);
 gboolean icd_request_tracking_info_delete (const gchar *sender);
+gboolean icd_request_tracking_info_rename (const gchar *sender,
+                                           const gchar *new_sender);
 void icd_request_tracking_info_add (struct icd_request *request,
                                     struct icd_tracking_info *track);
 
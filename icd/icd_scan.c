@@ -5,9 +5,12 @@
 #include "icd_network_priority.h"
 #include "icd_srv_provider.h"
 #include "icd_gconf.h"
+#include "icd_string.h"
+#include "icd_iap.h"
 
 #include <time.h>
 #include <string.h>
+#include <stdlib.h>
 
 static gboolean icd_scan_network(struct icd_network_module *module, const gchar *network_type);
 
@@ -15,21 +18,101 @@ static gboolean icd_scan_network(struct icd_network_module *module, const gchar
 struct icd_scan_listener {
   /** network type */
   gchar *type;
+  /** network types matching type, see #icd_network_api_type_prefix_mask */
+  guint32 type_mask;
   /** callback */
   icd_scan_cb_fn cb;
   /** callback data */
   gpointer user_data;
+  /** scan result filter or NULL to receive all results */
+  struct icd_scan_filter *filter;
 };
 
-/**
- * helper structure for communicating module and expiration to hash table
- * remove callback
- */
-struct icd_scan_expire_network_data {
-  /** module */
-  struct icd_network_module *module;
-  /** expiration time */
-  guint expire;
+/** maximum number of expired entries remembered for delta resync */
+#define ICD_SCAN_HISTORY_MAX   128
+
+/** scan cache change history */
+struct icd_scan_history {
+  /** random id of this ICd2 instance, the generations of another instance
+   *  are meaningless */
+  guint epoch;
+  /** generation of the latest change in any scan cache */
+  guint generation;
+  /** #icd_scan_cache copies of expired entries, oldest first */
+  GQueue *expired;
+  /** generation of the latest expired entry dropped from the history */
+  guint dropped;
+};
+
+/** number of new, updated or expired networks in one scan round after
+ * which the scan interval drops back to the module search interval */
+#define ICD_SCAN_CHURN_SPIKE   3
+
+/** default minimum change in dB before listeners are notified about a
+ * network again; 0 reports every change */
+#define ICD_SCAN_DB_HYSTERESIS_DEFAULT   0
+
+/** default minimum seconds between notifications about the same network */
+#define ICD_SCAN_NOTIFY_INTERVAL_DEFAULT   0
+
+/** default seconds after a completed scan during which new listeners get
+ * the cached results without a new scan being started */
+#define ICD_SCAN_FRESH_AGE_DEFAULT   10
+
+/** default maximum number of entries in a module scan cache */
+#define ICD_SCAN_CACHE_MAX_DEFAULT   256
+
+/** number of evictable entries from the least recently seen end of the
+ * cache that are considered when choosing one to evict */
+#define ICD_SCAN_EVICT_WINDOW   16
+
+/** directory for the scan cache snapshots */
+#define ICD_SCAN_SNAPSHOT_DIR   "/var/cache/icd2"
+
+/** first line of a scan cache snapshot file */
+#define ICD_SCAN_SNAPSHOT_HEADER   "icd2-scan-cache 1"
+
+/** minimum seconds between snapshots saved after completed scans */
+#define ICD_SCAN_SNAPSHOT_INTERVAL   300
+
+/** scan result submitted from another thread with #icd_scan_cb_threaded */
+struct icd_scan_result {
+  /** next result, newer ones first */
+  struct icd_scan_result *next;
+
+  /** search status */
+  enum icd_network_search_status status;
+  /** name of the network displayable to user */
+  gchar *network_name;
+  /** type of network */
+  gchar *network_type;
+  /** network attributes */
+  guint network_attrs;
+  /** network id */
+  gchar *network_id;
+  /** signal level */
+  enum icd_nw_levels signal;
+  /** base station MAC address */
+  gchar *station_id;
+  /** raw signal strength */
+  gint dB;
+  /** the network module */
+  gpointer search_cb_token;
+};
+
+/** lock-free stack of #icd_scan_result waiting to be applied in the main
+ * loop; producers push with compare and exchange and the main loop takes
+ * the whole stack at once */
+static volatile gpointer icd_scan_result_queue = NULL;
+
+/** how to change the scan interval when scheduling the next scan */
+enum icd_scan_interval_change {
+  /** no changes in the last scan, stretch the interval */
+  ICD_SCAN_BACKOFF,
+  /** many changes or a new listener, use the module search interval */
+  ICD_SCAN_RESET,
+  /** keep the current interval */
+  ICD_SCAN_KEEP
 };
 
 /** scan status name strings */
@@ -43,25 +126,246 @@ static const gchar const *icd_scan_status_names[] =
 };
 
 /**
- * @brief Helper function for comparing two strings where a NULL string is equal
- * to another NULL string
+ * @brief Get the scan cache record allocation counters
  *
- * @param a string A
- * @param b string B
+ * @return the allocation counters
+ *
+ */
+struct icd_scan_alloc_stats *
+icd_scan_alloc_stats_get(void)
+{
+  static struct icd_scan_alloc_stats stats;
+
+  return &stats;
+}
+
+/**
+ * @brief Allocate a zeroed scan cache entry; free it with
+ * #icd_scan_cache_entry_free
  *
- * @return TRUE if equal, FALSE if unequal
+ * @return the new cache entry
  *
  */
-inline static gboolean
-string_equal(const char *a, const char *b)
+struct icd_scan_cache *
+icd_scan_cache_entry_new(void)
 {
-  if (!a)
-    return !b;
+  struct icd_scan_alloc_stats *stats = icd_scan_alloc_stats_get();
 
-  if (b)
-    return !strcmp(a, b);
+  stats->cache_entries++;
+  stats->cache_entries_total++;
 
-  return FALSE;
+  return g_slice_new0(struct icd_scan_cache);
+}
+
+/**
+ * @brief Allocate a zeroed service provider record; it is freed along with
+ * the cache entry it is added to
+ *
+ * @return the new service provider record
+ *
+ */
+struct icd_scan_srv_provider *
+icd_scan_srv_provider_new(void)
+{
+  struct icd_scan_alloc_stats *stats = icd_scan_alloc_stats_get();
+
+  stats->srv_providers++;
+  stats->srv_providers_total++;
+
+  return g_slice_new0(struct icd_scan_srv_provider);
+}
+
+/**
+ * @brief Get the scan cache change history
+ *
+ * @return the scan cache change history
+ *
+ */
+static struct icd_scan_history *
+icd_scan_history_get(void)
+{
+  static struct icd_scan_history history = {0, 0, NULL, 0};
+
+  if (!history.expired)
+  {
+    history.expired = g_queue_new();
+
+    /* never 0, which the client uses for no epoch */
+    while (!history.epoch)
+      history.epoch = g_random_int();
+  }
+
+  return &history;
+}
+
+/**
+ * @brief Mark a cache entry as changed by giving it the next scan cache
+ * generation
+ *
+ * @param cache_entry the cache entry that got added or updated
+ *
+ */
+void
+icd_scan_cache_entry_changed(struct icd_scan_cache *cache_entry)
+{
+  cache_entry->generation = ++icd_scan_history_get()->generation;
+}
+
+/**
+ * @brief Get the current scan cache generation
+ *
+ * @return the generation of the latest change in any scan cache
+ *
+ */
+guint
+icd_scan_cache_generation(void)
+{
+  return icd_scan_history_get()->generation;
+}
+
+/**
+ * @brief Get the scan cache epoch
+ *
+ * @return the random id of this ICd2 instance that the scan cache generations
+ * belong to
+ *
+ */
+guint
+icd_scan_cache_epoch(void)
+{
+  return icd_scan_history_get()->epoch;
+}
+
+/**
+ * @brief Get the serial number of the listener notification
+ *
+ * @return pointer to the serial number
+ *
+ */
+static guint *
+icd_scan_notify_serial_get(void)
+{
+  static guint serial = 0;
+
+  return &serial;
+}
+
+/**
+ * @brief Get the serial number of the listener notification being delivered;
+ * all listeners called for the same notification see the same serial number
+ *
+ * @return the serial number of the notification
+ *
+ */
+guint
+icd_scan_listener_notify_serial(void)
+{
+  return *icd_scan_notify_serial_get();
+}
+
+/**
+ * @brief Free a change history copy of a removed cache entry
+ *
+ * @param expired the history copy
+ *
+ */
+static void
+icd_scan_history_entry_free(struct icd_scan_cache *expired)
+{
+  icd_string_unref(expired->network_type);
+  g_free(expired->network_name);
+  icd_string_unref(expired->network_id);
+  g_slice_free(struct icd_scan_cache, expired);
+}
+
+/**
+ * @brief Remember a removed cache entry so that clients doing a delta resync
+ * learn about the removal; the copy is not counted in the scan
+ * cache allocation statistics
+ *
+ * @param cache_entry the cache entry being removed
+ *
+ */
+static void
+icd_scan_history_add_expired(struct icd_scan_cache *cache_entry)
+{
+  struct icd_scan_history *history = icd_scan_history_get();
+  struct icd_scan_cache *expired = g_slice_new0(struct icd_scan_cache);
+
+  expired->last_seen = time(NULL);
+  expired->network_type = (gchar *)icd_string_ref(cache_entry->network_type);
+  expired->network_name = g_strdup(cache_entry->network_name);
+  expired->network_attrs = cache_entry->network_attrs;
+  expired->network_id = (gchar *)icd_string_ref(cache_entry->network_id);
+  expired->generation = ++history->generation;
+  g_queue_push_tail(history->expired, expired);
+
+  if (g_queue_get_length(history->expired) > ICD_SCAN_HISTORY_MAX)
+  {
+    expired = (struct icd_scan_cache *)g_queue_pop_head(history->expired);
+    history->dropped = expired->generation;
+    icd_scan_history_entry_free(expired);
+  }
+}
+
+/**
+ * @brief Add a listener to the module's per network type dispatch table
+ *
+ * @param module the network module
+ * @param listener the listener
+ *
+ */
+static void
+icd_scan_listener_dispatch_add(struct icd_network_module *module,
+                               struct icd_scan_listener *listener)
+{
+  guint id;
+
+  if (!listener->type)
+  {
+    module->scan_listener_dispatch[ICD_NW_TYPE_ID_NONE] = g_slist_prepend(
+          module->scan_listener_dispatch[ICD_NW_TYPE_ID_NONE], listener);
+    return;
+  }
+
+  for (id = 1; id <= ICD_NW_TYPE_ID_MAX; id++)
+  {
+    if (listener->type_mask & ICD_NW_TYPE_MASK(id))
+    {
+      module->scan_listener_dispatch[id] =
+          g_slist_prepend(module->scan_listener_dispatch[id], listener);
+    }
+  }
+}
+
+/**
+ * @brief Remove a listener from the module's per network type dispatch table
+ *
+ * @param module the network module
+ * @param listener the listener
+ *
+ */
+static void
+icd_scan_listener_dispatch_remove(struct icd_network_module *module,
+                                  struct icd_scan_listener *listener)
+{
+  guint id;
+
+  if (!listener->type)
+  {
+    module->scan_listener_dispatch[ICD_NW_TYPE_ID_NONE] = g_slist_remove(
+          module->scan_listener_dispatch[ICD_NW_TYPE_ID_NONE], listener);
+    return;
+  }
+
+  for (id = 1; id <= ICD_NW_TYPE_ID_MAX; id++)
+  {
+    if (listener->type_mask & ICD_NW_TYPE_MASK(id))
+    {
+      module->scan_listener_dispatch[id] =
+          g_slist_remove(module->scan_listener_dispatch[id], listener);
+    }
+  }
 }
 
 /**
@@ -88,6 +392,15 @@ icd_scan_listener_remove(struct icd_network_module *module, icd_scan_cb_fn cb,
         (scan_listener && scan_listener->cb == cb &&
          scan_listener->user_data == user_data))
     {
+      icd_scan_listener_dispatch_remove(module, scan_listener);
+
+      if (scan_listener->filter)
+      {
+        g_free(scan_listener->filter->service_type);
+        g_free(scan_listener->filter->network_id);
+        g_free(scan_listener->filter);
+      }
+
       g_free(scan_listener->type);
       g_free(scan_listener);
       module->scan_listener_list =
@@ -137,6 +450,243 @@ icd_scan_results_unregister(icd_scan_cb_fn cb, gpointer user_data)
   return rv;
 }
 
+/**
+ * @brief Hash function for the scan cache index; the key is an
+ * #icd_scan_cache structure of which only network type, attributes and id are
+ * used; network type and id are interned strings
+ *
+ * @param key the #icd_scan_cache structure
+ *
+ * @return the hash value
+ *
+ */
+static guint
+icd_scan_cache_key_hash(gconstpointer key)
+{
+  const struct icd_scan_cache *cache_entry =
+      (const struct icd_scan_cache *)key;
+  guint hash = cache_entry->network_attrs;
+
+  hash = (hash << 5) - hash + g_direct_hash(cache_entry->network_type);
+  hash = (hash << 5) - hash + g_direct_hash(cache_entry->network_id);
+
+  return hash;
+}
+
+/**
+ * @brief Equality function for the scan cache index; network type and id are
+ * interned strings and compared as pointers
+ *
+ * @param a #icd_scan_cache structure A
+ * @param b #icd_scan_cache structure B
+ *
+ * @return TRUE if network type, attributes and id are equal, FALSE otherwise
+ *
+ */
+static gboolean
+icd_scan_cache_key_equal(gconstpointer a, gconstpointer b)
+{
+  const struct icd_scan_cache *cache_a = (const struct icd_scan_cache *)a;
+  const struct icd_scan_cache *cache_b = (const struct icd_scan_cache *)b;
+
+  return cache_a->network_attrs == cache_b->network_attrs &&
+      cache_a->network_id == cache_b->network_id &&
+      cache_a->network_type == cache_b->network_type;
+}
+
+/**
+ * @brief Get the scan cache snapshot file name of a network module
+ *
+ * @param module the network module
+ *
+ * @return the file name, to be freed by the caller
+ *
+ */
+static gchar *
+icd_scan_snapshot_file(struct icd_network_module *module)
+{
+  gchar *base = g_path_get_basename(module->name);
+  gchar *file = g_strdup_printf(ICD_SCAN_SNAPSHOT_DIR "/%s.scan", base);
+
+  g_free(base);
+
+  return file;
+}
+
+/**
+ * @brief Save the scan cache of a network module to its snapshot file; the
+ * file has one tab separated, escaped line per entry in last_seen order.
+ * Service provider entries are left out, they are identified again after
+ * the next scan.
+ *
+ * @param module the network module
+ *
+ */
+static void
+icd_scan_snapshot_save(struct icd_network_module *module)
+{
+  GString *snapshot;
+  gchar *file;
+  GError *err = NULL;
+  GList *l;
+
+  if (!module->scan_expire_queue)
+    return;
+
+  if (g_mkdir_with_parents(ICD_SCAN_SNAPSHOT_DIR, 0755))
+  {
+    ILOG_WARN("could not create scan cache snapshot directory '%s'",
+              ICD_SCAN_SNAPSHOT_DIR);
+    return;
+  }
+
+  snapshot = g_string_new(ICD_SCAN_SNAPSHOT_HEADER "\n");
+
+  for (l = module->scan_expire_queue->head; l; l = l->next)
+  {
+    struct icd_scan_cache *cache_entry = (struct icd_scan_cache *)l->data;
+    gchar *type, *id, *name, *station;
+
+    if (cache_entry->network_attrs & ICD_NW_ATTR_SRV_PROVIDER)
+      continue;
+
+    type = g_strescape(cache_entry->network_type, NULL);
+    id = g_strescape(cache_entry->network_id, NULL);
+    name = g_strescape(cache_entry->network_name ?
+                       cache_entry->network_name : "", NULL);
+    station = g_strescape(cache_entry->station_id ?
+                          cache_entry->station_id : "", NULL);
+
+    g_string_append_printf(snapshot, "%u\t%u\t%d\t%d\t%s\t%s\t%s\t%s\n",
+                           cache_entry->last_seen, cache_entry->network_attrs,
+                           cache_entry->signal, cache_entry->dB, type, id,
+                           name, station);
+    g_free(type);
+    g_free(id);
+    g_free(name);
+    g_free(station);
+  }
+
+  file = icd_scan_snapshot_file(module);
+
+  if (!g_file_set_contents(file, snapshot->str, snapshot->len, &err))
+  {
+    ILOG_WARN("could not save scan cache snapshot '%s': %s", file,
+              err->message);
+    g_clear_error(&err);
+  }
+  else
+    module->scan_snapshot_saved = time(NULL);
+
+  g_free(file);
+  g_string_free(snapshot, TRUE);
+}
+
+/**
+ * @brief Restore the scan cache of a network module from its snapshot file;
+ * entries older than the module search lifetime or of network types the
+ * module no longer handles are skipped and the rest are marked stale until a
+ * scan sees them again. Call after the network types have been mapped to
+ * the modules.
+ *
+ * @param module the network module
+ *
+ */
+void
+icd_scan_cache_restore(struct icd_network_module *module)
+{
+  gchar *file = icd_scan_snapshot_file(module);
+  gchar *contents = NULL;
+  gchar **lines;
+  guint now = time(NULL);
+  guint restored = 0;
+  gint i;
+
+  if (!g_file_get_contents(file, &contents, NULL, NULL))
+  {
+    g_free(file);
+    return;
+  }
+
+  lines = g_strsplit(contents, "\n", 0);
+  g_free(contents);
+
+  if (!lines[0] || strcmp(lines[0], ICD_SCAN_SNAPSHOT_HEADER))
+  {
+    ILOG_WARN("ignoring unknown scan cache snapshot '%s'", file);
+    g_strfreev(lines);
+    g_free(file);
+    return;
+  }
+
+  for (i = 1; lines[i]; i++)
+  {
+    gchar **fields = g_strsplit(lines[i], "\t", 8);
+    struct icd_scan_cache *cache_entry;
+    gchar *type, *id;
+    guint last_seen;
+
+    if (g_strv_length(fields) != 8)
+    {
+      g_strfreev(fields);
+      continue;
+    }
+
+    last_seen = strtoul(fields[0], NULL, 10);
+
+    if (last_seen > now)
+      last_seen = now;
+
+    type = g_strcompress(fields[4]);
+    id = g_strcompress(fields[5]);
+
+    if (last_seen + module->nw.search_lifetime <= now ||
+        !icd_network_api_has_type(module, type) ||
+        icd_scan_cache_entry_find(module, type, strtoul(fields[1], NULL, 10),
+                                  id))
+    {
+      g_free(type);
+      g_free(id);
+      g_strfreev(fields);
+      continue;
+    }
+
+    cache_entry = icd_scan_cache_entry_new();
+    cache_entry->last_seen = last_seen;
+    cache_entry->network_attrs = strtoul(fields[1], NULL, 10);
+    cache_entry->signal = (enum icd_nw_levels)atoi(fields[2]);
+    cache_entry->dB = atoi(fields[3]);
+    cache_entry->network_type = (gchar *)icd_string_ref(type);
+    cache_entry->network_id = (gchar *)icd_string_ref(id);
+    cache_entry->network_name = g_strcompress(fields[6]);
+
+    if (*fields[7])
+      cache_entry->station_id = g_strcompress(fields[7]);
+
+    cache_entry->network_type_id = icd_scan_network_type_id(type);
+    cache_entry->network_priority =
+        icd_network_priority_get(NULL, NULL, cache_entry->network_type,
+                                 cache_entry->network_attrs);
+    cache_entry->last_notified = last_seen;
+    cache_entry->notified_dB = cache_entry->dB;
+    cache_entry->stale = TRUE;
+
+    icd_scan_cache_entry_add(module, cache_entry);
+    restored++;
+
+    g_free(type);
+    g_free(id);
+    g_strfreev(fields);
+  }
+
+  if (restored)
+    ILOG_INFO("module '%s' restored %u scan cache entries", module->name,
+              restored);
+
+  g_strfreev(lines);
+  g_free(file);
+}
+
 /**
  * @brief Set up the scan cache for a network module
  *
@@ -154,8 +704,20 @@ icd_scan_cache_init(struct icd_network_module *module)
     return FALSE;
   }
 
-  module->scan_cache_table =
-      g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  module->scan_cache_table = g_hash_table_new(icd_scan_cache_key_hash,
+                                              icd_scan_cache_key_equal);
+  module->scan_cache_id_table =
+      g_hash_table_new_full(g_str_hash, g_str_equal,
+                            (GDestroyNotify)icd_string_unref, NULL);
+  module->scan_cache_iap_table =
+      g_hash_table_new_full(g_str_hash, g_str_equal,
+                            (GDestroyNotify)icd_string_unref, NULL);
+  module->scan_cache_station_table =
+      g_hash_table_new_full(g_str_hash, g_str_equal,
+                            (GDestroyNotify)icd_string_unref, NULL);
+  module->scan_expire_queue = g_queue_new();
+  module->scan_interval = module->nw.search_interval;
+  module->scan_cache_max = ICD_SCAN_CACHE_MAX_DEFAULT;
 
   return TRUE;
 }
@@ -169,6 +731,7 @@ icd_scan_cache_init(struct icd_network_module *module)
 void
 icd_scan_cache_entry_free(struct icd_scan_cache *cache_entry)
 {
+  struct icd_scan_alloc_stats *stats = icd_scan_alloc_stats_get();
   GSList *l;
 
   for (l = cache_entry->srv_provider_list; l; l = g_slist_delete_link(l, l))
@@ -178,56 +741,150 @@ icd_scan_cache_entry_free(struct icd_scan_cache *cache_entry)
 
     if (provider)
     {
-      g_free(provider->service_type);
+      icd_string_unref(provider->service_type);
       g_free(provider->service_name);
-      g_free(provider->service_id);
+      icd_string_unref(provider->service_id);
+      g_slice_free(struct icd_scan_srv_provider, provider);
+      stats->srv_providers--;
     }
-
-    g_free(provider);
   }
 
-  g_free(cache_entry->network_type);
+  icd_string_unref(cache_entry->network_type);
   g_free(cache_entry->network_name);
-  g_free(cache_entry->network_id);
+  icd_string_unref(cache_entry->network_id);
   g_free(cache_entry->station_id);
-  g_free(cache_entry);
+  g_slist_free(cache_entry->srv_identified_list);
+  g_slice_free(struct icd_scan_cache, cache_entry);
+  stats->cache_entries--;
 }
 
 /**
- * @brief Send the cache entry to the listener if the network type matches
+ * @brief Get the network type id of a network type
  *
- * @param srv_provider send only this service provider to the listener if set;
- * send all network and service provider entries if NULL
- * @param cache_entry the cache entry
- * @param listener the listener
- * @param status the status of the supplied cache entry
+ * @param network_type the network type
+ *
+ * @return the network type id or #ICD_NW_TYPE_ID_NONE
+ *
+ */
+guint
+icd_scan_network_type_id(const gchar *network_type)
+{
+  struct icd_network_type *type = icd_network_api_type_get(network_type);
+
+  return type ? type->id : ICD_NW_TYPE_ID_NONE;
+}
+
+/**
+ * @brief Check whether a network passes a listener's scan filter
+ *
+ * @param filter the scan filter or NULL
+ * @param cache_entry the network
  *
- * @return TRUE if the type matched and listener was updated; FALSE otherwise
+ * @return TRUE if the network is to be sent to the listener, FALSE otherwise
  *
  */
 static gboolean
-icd_scan_listener_send_entry(struct icd_scan_srv_provider *srv_provider,
-                             struct icd_scan_cache *cache_entry,
-                             struct icd_scan_listener *listener,
-                             enum icd_scan_status status)
+icd_scan_filter_match_network(const struct icd_scan_filter *filter,
+                              const struct icd_scan_cache *cache_entry)
 {
-  if (!cache_entry)
-  {
-    ILOG_ERR("scan cannot send NULL cache_entry, because nw type unknown");
+  if (!filter)
+    return TRUE;
+
+  if (cache_entry->signal < filter->min_signal)
     return FALSE;
-  }
 
-  if (listener->type &&
-      strncmp(listener->type, cache_entry->network_type,
-              strlen(listener->type)))
-  {
+  if ((cache_entry->network_attrs & filter->attrs_required) !=
+      filter->attrs_required)
     return FALSE;
-  }
+
+  if (cache_entry->network_attrs & filter->attrs_forbidden)
+    return FALSE;
+
+  if (filter->saved_only &&
+      !(cache_entry->network_attrs & ICD_NW_ATTR_IAPNAME))
+    return FALSE;
+
+  if (filter->network_id &&
+      !icd_string_equal(filter->network_id, cache_entry->network_id))
+    return FALSE;
+
+  return TRUE;
+}
+
+/**
+ * @brief Check whether a service provider passes a listener's scan filter
+ *
+ * @param filter the scan filter or NULL
+ * @param srv_provider the service provider or NULL for the plain network
+ *
+ * @return TRUE if the service provider is to be sent to the listener, FALSE
+ * otherwise
+ *
+ */
+static gboolean
+icd_scan_filter_match_srv(const struct icd_scan_filter *filter,
+                          const struct icd_scan_srv_provider *srv_provider)
+{
+  if (!filter || !filter->service_type)
+    return TRUE;
+
+  return srv_provider && srv_provider->service_type &&
+      !strcmp(srv_provider->service_type, filter->service_type);
+}
+
+/**
+ * @brief Send the cache entry to the listener if the network type matches
+ * and the entry passes the listener's scan filter
+ *
+ * @param srv_provider send only this service provider to the listener if set;
+ * send all network and service provider entries if NULL
+ * @param cache_entry the cache entry
+ * @param listener the listener
+ * @param status the status of the supplied cache entry
+ *
+ * @return TRUE if the type and filter matched and listener was updated; FALSE
+ * otherwise
+ *
+ */
+static gboolean
+icd_scan_listener_send_entry(struct icd_scan_srv_provider *srv_provider,
+                             struct icd_scan_cache *cache_entry,
+                             struct icd_scan_listener *listener,
+                             enum icd_scan_status status)
+{
+  if (!cache_entry)
+  {
+    ILOG_ERR("scan cannot send NULL cache_entry, because nw type unknown");
+    return FALSE;
+  }
+
+  if (listener->type)
+  {
+    if (cache_entry->network_type_id != ICD_NW_TYPE_ID_NONE)
+    {
+      if (!(listener->type_mask &
+            ICD_NW_TYPE_MASK(cache_entry->network_type_id)))
+        return FALSE;
+    }
+    else if (strncmp(listener->type, cache_entry->network_type,
+                     strlen(listener->type)))
+      return FALSE;
+  }
 
   if (status == ICD_SCAN_COMPLETE)
+  {
     listener->cb(ICD_SCAN_COMPLETE, 0, cache_entry, listener->user_data);
-  else if (srv_provider)
+    return TRUE;
+  }
+
+  if (!icd_scan_filter_match_network(listener->filter, cache_entry))
+    return FALSE;
+
+  if (srv_provider)
   {
+    if (!icd_scan_filter_match_srv(listener->filter, srv_provider))
+      return FALSE;
+
     ILOG_DEBUG("sending %s nw %s/%0x/%s srv %s/%0x/%s",
                icd_scan_status_names[status],
                cache_entry->network_type,
@@ -242,7 +899,8 @@ icd_scan_listener_send_entry(struct icd_scan_srv_provider *srv_provider,
   {
     GSList *l;
 
-    if (!(cache_entry->network_attrs & ICD_NW_ATTR_SRV_PROVIDER))
+    if (!(cache_entry->network_attrs & ICD_NW_ATTR_SRV_PROVIDER) &&
+        icd_scan_filter_match_srv(listener->filter, NULL))
     {
       listener->cb(status, NULL, cache_entry, listener->user_data);
       ILOG_DEBUG("sending %s nw %s/%0x/%s srv -/-/-",
@@ -257,7 +915,7 @@ icd_scan_listener_send_entry(struct icd_scan_srv_provider *srv_provider,
       struct icd_scan_srv_provider *provider =
           (struct icd_scan_srv_provider *)l->data;
 
-      if (provider)
+      if (provider && icd_scan_filter_match_srv(listener->filter, provider))
       {
         ILOG_DEBUG("sending %s nw %s/%0x/%s srv %s/%0x/%s",
                    icd_scan_status_names[status],
@@ -275,37 +933,6 @@ icd_scan_listener_send_entry(struct icd_scan_srv_provider *srv_provider,
   return TRUE;
 }
 
-/**
- * @brief Check for elements, return immediately on first element found
- *
- * @param key the network_id, not used
- * @param value the #icd_scan_cache_list
- * @param user_data not used
- *
- * @return TRUE on first non-NULL element found
- *
- */
-static gboolean
-icd_scan_cache_element_check(gpointer key,
-                             gpointer value,
-                             gpointer user_data)
-{
-  struct icd_scan_cache_list *scan_cache_list =
-      (struct icd_scan_cache_list *)value;
-  GSList *cache_list;
-  gboolean rv = FALSE;
-
-  if (scan_cache_list && (cache_list = scan_cache_list->cache_list))
-  {
-    if (cache_list->data)
-      rv = TRUE;
-  }
-
-  ILOG_DEBUG("scan cache contains %d elements", rv ? 1 : 0);
-
-  return rv;
-}
-
 /**
  * @brief Check wheter a scan cache has any elements
  *
@@ -317,10 +944,11 @@ icd_scan_cache_element_check(gpointer key,
 static gboolean
 icd_scan_cache_has_elements(struct icd_network_module *module)
 {
-  int user_data = 0;
+  guint elements = g_hash_table_size(module->scan_cache_table);
 
-  return !!g_hash_table_find(module->scan_cache_table,
-                             (GHRFunc)icd_scan_cache_element_check, &user_data);
+  ILOG_DEBUG("scan cache contains %d elements", elements);
+
+  return elements != 0;
 }
 
 /**
@@ -338,7 +966,9 @@ icd_scan_listener_exist(struct icd_network_module *module)
 }
 
 /**
- * @brief Notify each matching listener about the change in the cache entry
+ * @brief Notify each matching listener about the change in the cache entry;
+ * only the listeners for the network type of the entry and the listeners for
+ * all network types are looked at
  *
  * @param module the network module
  * @param srv_provider NULL or the specific service provider entry that got
@@ -356,7 +986,30 @@ icd_scan_listener_notify(struct icd_network_module *module,
 {
   GSList *l;
 
-  for (l = module->scan_listener_list; l; l = l->next)
+  (*icd_scan_notify_serial_get())++;
+
+  /* entries of network types without an id can be matched only by comparing
+     the network type strings */
+  if (cache_entry->network_type_id == ICD_NW_TYPE_ID_NONE)
+  {
+    for (l = module->scan_listener_list; l; l = l->next)
+    {
+      icd_scan_listener_send_entry(srv_provider, cache_entry,
+                                   (struct icd_scan_listener *)l->data,
+                                   status);
+    }
+
+    return;
+  }
+
+  for (l = module->scan_listener_dispatch[cache_entry->network_type_id]; l;
+       l = l->next)
+  {
+    icd_scan_listener_send_entry(srv_provider, cache_entry,
+                                 (struct icd_scan_listener *)l->data, status);
+  }
+
+  for (l = module->scan_listener_dispatch[ICD_NW_TYPE_ID_NONE]; l; l = l->next)
   {
     icd_scan_listener_send_entry(srv_provider, cache_entry,
                                  (struct icd_scan_listener *)l->data, status);
@@ -364,303 +1017,629 @@ icd_scan_listener_notify(struct icd_network_module *module,
 }
 
 /**
- * @brief  Hash table callback for removing an entry. Note that this function is
- * also called outside of hash, so care should be taken when dealing with the
- * hash (that is why list_entry is not deleted inside this function).
+ * @brief Add a cache entry to a view of the scan cache
  *
- * @param key the network_id
- * @param value the icd_scan_cache_list struct
- * @param user_data expiration time
- *
- * @return TRUE when all networks for the network_id have been expired and the
- * hash table element can be removed; FALSE otherwise
+ * @param table the view hash table
+ * @param key the key the entry is added with
+ * @param cache_entry the cache entry to add
  *
  */
-static gboolean
-icd_scan_expire_network(gpointer key, gpointer value, gpointer user_data)
+static void
+icd_scan_cache_view_add(GHashTable *table, const gchar *key,
+                        struct icd_scan_cache *cache_entry)
 {
-  struct icd_scan_cache_list *scan_cache_list =
-      (struct icd_scan_cache_list *)value;
-  struct icd_scan_expire_network_data *expire_network_data =
-      (struct icd_scan_expire_network_data *)user_data;
-  gchar *network_id = (gchar *)key;
-  GSList *l = scan_cache_list->cache_list;
-  int expired = 0;
-  int entries = 0;
-
-  while (l)
-  {
-    struct icd_scan_cache *cache_entry = (struct icd_scan_cache *)l->data;
-    GSList *next = l->next;
-
-    if (cache_entry)
-    {
-      if (cache_entry->last_seen <= expire_network_data->expire)
-      {
-        icd_scan_listener_notify(
-              expire_network_data->module, NULL, cache_entry, ICD_SCAN_EXPIRE);
-        icd_scan_cache_entry_free(cache_entry);
-        ++expired;
-      }
-    }
-    else
-      ILOG_ERR("NULL cache entry in network '%s'", network_id);
+  struct icd_scan_cache_list *scan_cache_list;
 
-    scan_cache_list->cache_list =
-        g_slist_delete_link(scan_cache_list->cache_list, l);
+  if (!table || !key)
+    return;
 
-    l = next;
-    entries++;
-  }
+  scan_cache_list = (struct icd_scan_cache_list *)
+      g_hash_table_lookup(table, key);
 
-  if (scan_cache_list->cache_list)
+  if (!scan_cache_list)
   {
-    if (expired)
-    {
-      ILOG_DEBUG("network id '%s' expired %d/%d entries", network_id, expired,
-                 entries);
-    }
-    return FALSE;
+    scan_cache_list = g_new0(struct icd_scan_cache_list, 1);
+    g_hash_table_insert(table, (gpointer)icd_string_ref(key),
+                        scan_cache_list);
   }
 
-  ILOG_DEBUG("network id '%s' all entries expired", network_id);
-  return TRUE;
+  scan_cache_list->cache_list = g_slist_prepend(scan_cache_list->cache_list,
+                                                cache_entry);
 }
 
-
 /**
- * @brief Hash table callback for removing an entry, this version is only called
- * from hash remove func.
+ * @brief Remove a cache entry from a view of the scan cache
  *
- * @param key the network_id
- * @param value the icd_scan_cache_list struct
- * @param user_data expiration time
- *
- * @return TRUE when all networks for the network_id have been expired and the
- * hash table element can be removed; FALSE otherwise
+ * @param table the view hash table
+ * @param key the key the entry was added with
+ * @param cache_entry the cache entry to remove
  *
  */
-static gboolean
-icd_scan_expire_network_for_hash(gpointer key, gpointer value,
-                                 gpointer user_data)
+static void
+icd_scan_cache_view_remove(GHashTable *table, const gchar *key,
+                           struct icd_scan_cache *cache_entry)
 {
-  if (icd_scan_expire_network(key, value, user_data))
+  struct icd_scan_cache_list *scan_cache_list;
+
+  if (!table || !key)
+    return;
+
+  scan_cache_list = (struct icd_scan_cache_list *)
+      g_hash_table_lookup(table, key);
+
+  if (!scan_cache_list)
   {
-    g_free(value);
-    return TRUE;
+    ILOG_ERR("key '%s' not in scan cache view", key);
+    return;
   }
 
-  return FALSE;
+  scan_cache_list->cache_list = g_slist_remove(scan_cache_list->cache_list,
+                                               cache_entry);
+
+  if (!scan_cache_list->cache_list)
+  {
+    ILOG_DEBUG("key '%s' all entries removed from view", key);
+    g_hash_table_remove(table, key);
+    g_free(scan_cache_list);
+  }
 }
 
 /**
- * @brief  Cache expiry function
- *
- * @param data cache timeout data
+ * @brief Remove a cache entry from the network_id, IAP name and station_id
+ * views of the scan cache
  *
- * @return FALSE to remove the timeout
+ * @param module the network module
+ * @param cache_entry the cache entry to remove
  *
  */
-static gboolean
-icd_scan_cache_expire(gpointer data)
+static void
+icd_scan_cache_views_remove(struct icd_network_module *module,
+                            struct icd_scan_cache *cache_entry)
 {
-  struct icd_scan_cache_timeout *scan_cache_timeout;
-
-  scan_cache_timeout = (struct icd_scan_cache_timeout *)data;
+  icd_scan_cache_view_remove(module->scan_cache_id_table,
+                             cache_entry->network_id, cache_entry);
 
-  if (scan_cache_timeout->module->scan_progress)
-    ILOG_DEBUG("deferred scan cache expiration for '%s' due to new scan",
-               scan_cache_timeout->module->name);
-  else
+  if (cache_entry->network_attrs & ICD_NW_ATTR_IAPNAME)
   {
-    struct icd_scan_expire_network_data user_data;
+    icd_scan_cache_view_remove(module->scan_cache_iap_table,
+                               cache_entry->network_id, cache_entry);
+  }
 
-    user_data.module = scan_cache_timeout->module;
-    user_data.expire = time(0) - scan_cache_timeout->module->nw.search_lifetime;
+  icd_scan_cache_view_remove(module->scan_cache_station_table,
+                             cache_entry->station_id, cache_entry);
+}
 
-    g_hash_table_foreach_remove(scan_cache_timeout->module->scan_cache_table,
-                                (GHRFunc)icd_scan_expire_network_for_hash,
-                                &user_data);
-  }
+/**
+ * @brief Change the station id of a cache entry and update the station_id
+ * view of the scan cache
+ *
+ * @param module the network module
+ * @param cache_entry the cache entry
+ * @param station_id the new station id
+ *
+ */
+static void
+icd_scan_cache_entry_set_station(struct icd_network_module *module,
+                                 struct icd_scan_cache *cache_entry,
+                                 const gchar *station_id)
+{
+  if (icd_string_equal(cache_entry->station_id, station_id))
+    return;
 
-  scan_cache_timeout->module->scan_timeout_list =
-      g_slist_remove(scan_cache_timeout->module->scan_timeout_list,
-                     scan_cache_timeout);
+  icd_scan_cache_view_remove(module->scan_cache_station_table,
+                             cache_entry->station_id, cache_entry);
+  g_free(cache_entry->station_id);
+  cache_entry->station_id = g_strdup(station_id);
+  icd_scan_cache_view_add(module->scan_cache_station_table,
+                          cache_entry->station_id, cache_entry);
+}
 
-  g_free(scan_cache_timeout);
+/**
+ * @brief Remove a cache entry from the scan cache index, the secondary
+ * views and the expiry queue; the entry itself is not freed
+ *
+ * @param module the network module
+ * @param cache_entry the cache entry to remove
+ *
+ */
+static void
+icd_scan_cache_entry_unlink(struct icd_network_module *module,
+                            struct icd_scan_cache *cache_entry)
+{
+  g_hash_table_remove(module->scan_cache_table, cache_entry);
+  icd_scan_cache_views_remove(module, cache_entry);
 
-  return FALSE;
+  if (cache_entry->expire_link)
+  {
+    g_queue_delete_link(module->scan_expire_queue, cache_entry->expire_link);
+    cache_entry->expire_link = NULL;
+  }
 }
 
-struct icd_scan_cache_list *
-icd_scan_cache_list_lookup(struct icd_network_module *module,
-                           const gchar *network_id)
+/**
+ * @brief Expire a cache entry, i.e. notify listeners about the expiration,
+ * record it in the change history and remove and free the entry
+ *
+ * @param module the network module
+ * @param cache_entry the cache entry to expire
+ *
+ */
+static void
+icd_scan_cache_entry_expire(struct icd_network_module *module,
+                            struct icd_scan_cache *cache_entry)
 {
-  if (!module || !module->scan_cache_table)
-    return NULL;
+  module->scan_churn++;
+  icd_scan_listener_notify(module, NULL, cache_entry, ICD_SCAN_EXPIRE);
+  icd_scan_cache_entry_unlink(module, cache_entry);
 
-  return (struct icd_scan_cache_list *)
-      g_hash_table_lookup(module->scan_cache_table, network_id);
+  /* every removal listeners see as expired is also seen by a delta resync */
+  icd_scan_history_add_expired(cache_entry);
+  icd_scan_cache_entry_free(cache_entry);
 }
 
+/**
+ * @brief Evict one entry from a full scan cache; among the least recently
+ * seen entries stale restored networks are preferred over scanned ones,
+ * networks without a saved IAP over saved ones and weak networks over strong
+ * ones. Entries backing an IAP in use are never evicted.
+ *
+ * @param module the network module
+ *
+ * @return TRUE if an entry was evicted, FALSE if there was nothing to evict
+ *
+ */
 static gboolean
-icd_scan_cache_remove_iap_for_module(struct icd_network_module *module,
-                                     gpointer user_data)
+icd_scan_cache_evict(struct icd_network_module *module)
 {
-  struct icd_scan_cache_list *scan_cache_list;
-  GSList *net_type;
+  struct icd_scan_cache *victim = NULL;
+  guint candidates = 0;
+  GList *l;
 
-  scan_cache_list = icd_scan_cache_list_lookup(module,
-                                               (const gchar *)user_data);
+  for (l = module->scan_expire_queue->head;
+       l && candidates < ICD_SCAN_EVICT_WINDOW; l = l->next)
+  {
+    struct icd_scan_cache *cache_entry = (struct icd_scan_cache *)l->data;
 
-  if (!scan_cache_list)
-    return TRUE;
+    if (icd_iap_find(cache_entry->network_type, cache_entry->network_attrs,
+                     cache_entry->network_id))
+      continue;
 
-  for (net_type = module->network_types; net_type; net_type = net_type->next)
-  {
-    GSList *cache_list = scan_cache_list->cache_list;
-    const gchar *network_type = (const gchar *)net_type->data;
-    GSList *next;
+    candidates++;
 
-    while (cache_list)
+    if (!victim)
+      victim = cache_entry;
+    else if (victim->stale != cache_entry->stale)
     {
-      struct icd_scan_cache *cache = (struct icd_scan_cache *)cache_list->data;
-      next = cache_list->next;
-
-      if (cache && cache->network_attrs & ICD_NW_ATTR_IAPNAME &&
-          string_equal(cache->network_type, network_type))
-      {
-        ILOG_DEBUG("removing %s, name=%s, attrs=0x%x, type=%s",
-                   cache->network_id,
-                   cache->network_name,
-                   cache->network_attrs,
-                   cache->network_type);
+      if (cache_entry->stale)
+        victim = cache_entry;
+    }
+    else if ((victim->network_attrs & ICD_NW_ATTR_IAPNAME) !=
+             (cache_entry->network_attrs & ICD_NW_ATTR_IAPNAME))
+    {
+      if (victim->network_attrs & ICD_NW_ATTR_IAPNAME)
+        victim = cache_entry;
+    }
+    else if (cache_entry->signal < victim->signal)
+      victim = cache_entry;
+  }
 
-        icd_scan_listener_notify(module, NULL, cache, ICD_SCAN_EXPIRE);
-        icd_scan_cache_entry_free(cache);
-        scan_cache_list->cache_list =
-            g_slist_delete_link(scan_cache_list->cache_list, cache_list);
+  if (!victim)
+    return FALSE;
 
-      }
+  ILOG_DEBUG("module '%s' scan cache full, evicting %s/%0x/%s",
+             module->name, victim->network_type, victim->network_attrs,
+             victim->network_id);
 
-      cache_list = next;
-    }
-  }
+  icd_scan_cache_entry_expire(module, victim);
 
   return TRUE;
 }
 
-void
-icd_scan_cache_remove_iap(gchar *iap_name)
+/**
+ * @brief Mark a cache entry as seen; the entry is moved to the end of the
+ * expiry queue
+ *
+ * @param module the network module
+ * @param cache_entry the cache entry
+ * @param now the current time
+ *
+ */
+static void
+icd_scan_cache_entry_seen(struct icd_network_module *module,
+                          struct icd_scan_cache *cache_entry,
+                          guint now)
 {
-  icd_network_api_foreach_module(icd_context_get(),
-                                 icd_scan_cache_remove_iap_for_module,
-                                 iap_name);
+  cache_entry->last_seen = now;
+
+  if (cache_entry->expire_link)
+  {
+    g_queue_unlink(module->scan_expire_queue, cache_entry->expire_link);
+    g_queue_push_tail_link(module->scan_expire_queue, cache_entry->expire_link);
+  }
 }
 
+static gboolean icd_scan_cache_expire(gpointer data);
+
 /**
- * @brief Remove scan cache from scan list, the removed entry does not call
- * listener.
- *
- * @param scan_cache_list the icd_scan_cache_list struct
- * @param network_id network identifier
- * @param network_type the network type
- * @param network_attrs network attributes
+ * @brief Arm the expiry timeout for the oldest entry in the scan cache unless
+ * the timeout is already running
  *
- * @return TRUE if scan entry was removed; FALSE otherwise
+ * @param module the network module
  *
  */
-gboolean
-icd_scan_cache_entry_remove(struct icd_scan_cache_list *scan_cache_list,
-                            const gchar *network_id,
-                            const gchar *network_type,
-                            const guint network_attrs)
+static void
+icd_scan_cache_expire_arm(struct icd_network_module *module)
 {
-  GSList *l = scan_cache_list->cache_list;
-  gint entries = 0;
+  struct icd_scan_cache *cache_entry;
+  guint now;
+  guint deadline;
+  guint delay = 0;
 
-  while (l)
-  {
-    struct icd_scan_cache *cache = (struct icd_scan_cache *)l->data;
-    GSList *next = l->next;
+  if (module->scan_timeout_expire)
+    return;
 
-    if (cache && cache->network_attrs == network_attrs &&
-        string_equal(cache->network_type, network_type))
-    {
-      GSList *tmp;
+  cache_entry = (struct icd_scan_cache *)
+      g_queue_peek_head(module->scan_expire_queue);
 
-      icd_scan_cache_entry_free(cache);
-      tmp = g_slist_delete_link(scan_cache_list->cache_list, l);
-      entries++;
-      l = next;
-      scan_cache_list->cache_list = tmp;
-    }
+  if (!cache_entry)
+    return;
 
-    l = next;
-  }
+  now = time(0);
+  deadline = cache_entry->last_seen + module->nw.search_lifetime;
 
-  if (!scan_cache_list->cache_list)
-    ILOG_DEBUG("network id '%s' all entries (%d) removed", network_id, entries);
+  if (deadline > now)
+    delay = deadline - now;
 
-  return !!entries;
+  /* guard against the wall clock having been set backwards */
+  if (delay > module->nw.search_lifetime)
+    delay = module->nw.search_lifetime;
+
+  module->scan_timeout_expire =
+      g_timeout_add(1000 * delay, icd_scan_cache_expire, module);
 }
 
-void
-icd_scan_cache_remove(struct icd_network_module *module)
+/**
+ * @brief Expire all cache entries last seen at or before the given time and
+ * rearm the expiry timeout for the remaining entries
+ *
+ * @param module the network module
+ * @param expire expiration time
+ *
+ */
+static void
+icd_scan_cache_expire_entries(struct icd_network_module *module, guint expire)
 {
-  GSList *l;
+  struct icd_scan_cache *cache_entry;
+  gint expired = 0;
 
-  if (module->scan_timeout_rescan)
+  while ((cache_entry = (struct icd_scan_cache *)
+          g_queue_peek_head(module->scan_expire_queue)) &&
+         cache_entry->last_seen <= expire)
   {
-    g_source_remove(module->scan_timeout_rescan);
-    module->scan_timeout_rescan = 0;
+    icd_scan_cache_entry_expire(module, cache_entry);
+    expired++;
   }
 
-  l = module->scan_timeout_list;
+  if (expired)
+    ILOG_DEBUG("module '%s' expired %d entries", module->name, expired);
 
-  while (l)
-  {
-    struct icd_scan_cache_timeout *timeout =
-        (struct icd_scan_cache_timeout *)l->data;
-    GSList *next = l->next;
+  icd_scan_cache_expire_arm(module);
+}
 
-    if (timeout)
-    {
-      g_source_remove(timeout->id);
-      g_free(timeout);
+/**
+ * @brief  Cache expiry function
+ *
+ * @param data the network module
+ *
+ * @return FALSE to remove the timeout
+ *
+ */
+static gboolean
+icd_scan_cache_expire(gpointer data)
+{
+  struct icd_network_module *module = (struct icd_network_module *)data;
+
+  module->scan_timeout_expire = 0;
+
+  /* the timeout is rearmed when the scan completes */
+  if (module->scan_progress)
+  {
+    ILOG_DEBUG("deferred scan cache expiration for '%s' due to new scan",
+               module->name);
+  }
+  else
+    icd_scan_cache_expire_entries(module, time(0) - module->nw.search_lifetime);
+
+  return FALSE;
+}
+
+/**
+ * @brief Look up all cache entries with the given network id
+ *
+ * @param module the network module
+ * @param network_id the network id
+ *
+ * @return the per network_id list of cache entries or NULL if none
+ *
+ */
+struct icd_scan_cache_list *
+icd_scan_cache_list_lookup(struct icd_network_module *module,
+                           const gchar *network_id)
+{
+  if (!module || !module->scan_cache_id_table || !network_id)
+    return NULL;
+
+  return (struct icd_scan_cache_list *)
+      g_hash_table_lookup(module->scan_cache_id_table, network_id);
+}
+
+/**
+ * @brief Look up all cache entries seen from the given station
+ *
+ * @param module the network module
+ * @param station_id the station id, e.g. the access point MAC address
+ *
+ * @return the per station_id list of cache entries or NULL if none
+ *
+ */
+struct icd_scan_cache_list *
+icd_scan_cache_station_lookup(struct icd_network_module *module,
+                              const gchar *station_id)
+{
+  if (!module || !module->scan_cache_station_table || !station_id)
+    return NULL;
+
+  return (struct icd_scan_cache_list *)
+      g_hash_table_lookup(module->scan_cache_station_table, station_id);
+}
+
+static gboolean
+icd_scan_cache_remove_iap_for_module(struct icd_network_module *module,
+                                     gpointer user_data)
+{
+  struct icd_scan_cache_list *scan_cache_list;
+  GSList *remove_list = NULL;
+  GSList *l;
+
+  if (!module->scan_cache_iap_table)
+    return TRUE;
+
+  scan_cache_list = (struct icd_scan_cache_list *)
+      g_hash_table_lookup(module->scan_cache_iap_table,
+                          (const gchar *)user_data);
+
+  if (!scan_cache_list)
+    return TRUE;
+
+  for (l = scan_cache_list->cache_list; l; l = l->next)
+  {
+    struct icd_scan_cache *cache = (struct icd_scan_cache *)l->data;
+    GSList *net_type;
+
+    if (!cache)
+      continue;
+
+    for (net_type = module->network_types; net_type; net_type = net_type->next)
+    {
+      if (icd_string_equal(cache->network_type, (const gchar *)net_type->data))
+      {
+        remove_list = g_slist_prepend(remove_list, cache);
+        break;
+      }
     }
-    else
-      ILOG_ERR("timeout data NULL");
+  }
 
-    module->scan_timeout_list =
-        g_slist_delete_link(module->scan_timeout_list, l);
-    l = next;
+  /* the per IAP name list is freed when its last entry is removed */
+  while (remove_list)
+  {
+    struct icd_scan_cache *cache = (struct icd_scan_cache *)remove_list->data;
+
+    ILOG_DEBUG("removing %s, name=%s, attrs=0x%x, type=%s",
+               cache->network_id,
+               cache->network_name,
+               cache->network_attrs,
+               cache->network_type);
+
+    icd_scan_cache_entry_expire(module, cache);
+    remove_list = g_slist_delete_link(remove_list, remove_list);
+  }
+
+  return TRUE;
+}
+
+void
+icd_scan_cache_remove_iap(gchar *iap_name)
+{
+  icd_network_api_foreach_module(icd_context_get(),
+                                 icd_scan_cache_remove_iap_for_module,
+                                 iap_name);
+}
+
+/**
+ * @brief Remove scan cache entry from the scan cache, the removed entry does
+ * not call listener.
+ *
+ * @param module the network module
+ * @param network_id network identifier
+ * @param network_type the network type
+ * @param network_attrs network attributes
+ *
+ * @return TRUE if scan entry was removed; FALSE otherwise
+ *
+ */
+gboolean
+icd_scan_cache_entry_remove(struct icd_network_module *module,
+                            const gchar *network_id,
+                            const gchar *network_type,
+                            const guint network_attrs)
+{
+  struct icd_scan_cache *cache_entry =
+      icd_scan_cache_entry_find(module, network_type, network_attrs,
+                                network_id);
+
+  if (!cache_entry)
+    return FALSE;
+
+  icd_scan_cache_entry_unlink(module, cache_entry);
+  icd_scan_cache_entry_free(cache_entry);
+
+  return TRUE;
+}
+
+static void icd_scan_result_queue_drain(void);
+
+void
+icd_scan_cache_remove(struct icd_network_module *module)
+{
+  /* apply results the module submitted from its threads before it was
+     destroyed */
+  icd_scan_result_queue_drain();
+
+  icd_scan_snapshot_save(module);
+
+  g_free(module->scan_target_id);
+  module->scan_target_id = NULL;
+
+  if (module->scan_timeout_rescan)
+  {
+    g_source_remove(module->scan_timeout_rescan);
+    module->scan_timeout_rescan = 0;
+  }
+
+  if (module->scan_timeout_expire)
+  {
+    g_source_remove(module->scan_timeout_expire);
+    module->scan_timeout_expire = 0;
+  }
+
+  if (module->scan_expire_queue)
+  {
+    struct icd_scan_cache *cache_entry;
+
+    while ((cache_entry = (struct icd_scan_cache *)
+            g_queue_peek_head(module->scan_expire_queue)))
+    {
+      icd_scan_cache_entry_expire(module, cache_entry);
+    }
+
+    g_queue_free(module->scan_expire_queue);
+    module->scan_expire_queue = NULL;
   }
 
   if (module->scan_cache_table)
   {
-    struct icd_scan_expire_network_data user_data;
+    g_hash_table_destroy(module->scan_cache_table);
+    module->scan_cache_table = NULL;
+  }
 
-    user_data.module = module;
-    user_data.expire = time(0) + 1;
-    g_hash_table_foreach_remove(module->scan_cache_table,
-                                (GHRFunc)icd_scan_expire_network_for_hash,
-                                &user_data);
+  if (module->scan_cache_id_table)
+  {
+    g_hash_table_destroy(module->scan_cache_id_table);
+    module->scan_cache_id_table = NULL;
+  }
+
+  if (module->scan_cache_iap_table)
+  {
+    g_hash_table_destroy(module->scan_cache_iap_table);
+    module->scan_cache_iap_table = NULL;
+  }
+
+  if (module->scan_cache_station_table)
+  {
+    g_hash_table_destroy(module->scan_cache_station_table);
+    module->scan_cache_station_table = NULL;
   }
 
   icd_scan_listener_remove(module, NULL, NULL);
+
+  ILOG_DEBUG("scan cache entries %u/%u, srv providers %u/%u, identifies "
+             "%u/%u allocated now/in total",
+             icd_scan_alloc_stats_get()->cache_entries,
+             icd_scan_alloc_stats_get()->cache_entries_total,
+             icd_scan_alloc_stats_get()->srv_providers,
+             icd_scan_alloc_stats_get()->srv_providers_total,
+             icd_scan_alloc_stats_get()->identifies,
+             icd_scan_alloc_stats_get()->identifies_total);
 }
 
 static void
 icd_scan_listener_send_list(gpointer key, gpointer value, gpointer user_data)
 {
-  GSList *l;
+  (*icd_scan_notify_serial_get())++;
+  icd_scan_listener_send_entry(NULL, (struct icd_scan_cache *)value,
+                               (struct icd_scan_listener *)user_data,
+                               ICD_SCAN_NEW);
+}
+
+static gboolean icd_scan_cache_rescan(gpointer data);
+
+/**
+ * @brief Get the longest scan interval for a network module; the interval
+ * leaves one normal scan interval of the cache lifetime for the scan itself,
+ * so that networks seen early in a scan do not expire before the next one.
+ * A module without a search lifetime is not backed off unless a maximum scan
+ * interval is configured.
+ *
+ * @param module the network module
+ *
+ * @return the longest scan interval in seconds
+ *
+ */
+static guint
+icd_scan_interval_max(struct icd_network_module *module)
+{
+  guint max;
+
+  if (module->nw.search_lifetime > module->nw.search_interval)
+    max = module->nw.search_lifetime - module->nw.search_interval;
+  else if (module->nw.search_lifetime == 0 && module->scan_interval_max)
+    max = module->scan_interval_max;
+  else
+    max = module->nw.search_interval;
 
-  for (l = ((struct icd_scan_cache_list *)value)->cache_list; l; l = l->next)
+  if (module->scan_interval_max && module->scan_interval_max < max)
+    max = module->scan_interval_max;
+
+  if (max < module->nw.search_interval)
+    max = module->nw.search_interval;
+
+  return max;
+}
+
+/**
+ * @brief Adjust the scan interval of a network module and schedule the next
+ * scan
+ *
+ * @param module the network module
+ * @param change how to change the scan interval
+ *
+ */
+static void
+icd_scan_schedule(struct icd_network_module *module,
+                  enum icd_scan_interval_change change)
+{
+  switch (change)
   {
-    icd_scan_listener_send_entry(NULL, (struct icd_scan_cache *)l->data,
-        (struct icd_scan_listener *)user_data, ICD_SCAN_NEW);
+    case ICD_SCAN_BACKOFF:
+      module->scan_interval = MIN(MAX(module->scan_interval * 2, 1),
+                                  icd_scan_interval_max(module));
+      break;
+    case ICD_SCAN_RESET:
+      module->scan_interval = module->nw.search_interval;
+      break;
+    case ICD_SCAN_KEEP:
+      break;
   }
+
+  ILOG_DEBUG("module '%s' next scan in %u s, %u changes in last scan",
+             module->name, module->scan_interval, module->scan_churn);
+
+  if (module->scan_timeout_rescan)
+    g_source_remove(module->scan_timeout_rescan);
+
+  module->scan_timeout_rescan =
+      g_timeout_add(1000 * module->scan_interval, icd_scan_cache_rescan,
+                    module);
 }
 
 static gboolean
@@ -678,6 +1657,289 @@ icd_scan_cache_rescan(gpointer data)
   return FALSE;
 }
 
+/**
+ * @brief Read a scan notification hysteresis, cache size or scan interval
+ * setting; unset uses the default and zero or a negative value disables the
+ * limit
+ *
+ * @param key_name gconf key
+ * @param def default value
+ *
+ * @return the setting, 0 if disabled
+ *
+ */
+static gint
+icd_scan_setting_get(const gchar *key_name, const gint def)
+{
+  gint value = icd_gconf_get_iap_int_default(NULL, key_name, def);
+
+  return value < 0 ? 0 : value;
+}
+
+/**
+ * @brief Check whether listeners need to be notified about a repeated
+ * sighting of a network
+ *
+ * @param module the network module
+ * @param cache_entry the cache entry
+ * @param status #ICD_SCAN_UPDATE or #ICD_SCAN_NOTIFY
+ * @param dB raw signal strength of the sighting
+ * @param now current time
+ *
+ * @return TRUE if listeners are to be notified, FALSE if the change is
+ * suppressed
+ *
+ */
+static gboolean
+icd_scan_cache_entry_notify_due(struct icd_network_module *module,
+                                struct icd_scan_cache *cache_entry,
+                                enum icd_scan_status status,
+                                gint dB, guint now)
+{
+  /* signal level changes are always reported, only rapid repeats and dB
+     jitter are suppressed */
+  if (status == ICD_SCAN_NOTIFY &&
+      (now - cache_entry->last_notified < module->scan_notify_interval ||
+       ABS(dB - cache_entry->notified_dB) < module->scan_db_hysteresis))
+    return FALSE;
+
+  cache_entry->last_notified = now;
+  cache_entry->notified_dB = dB;
+
+  return TRUE;
+}
+
+/**
+ * @brief Apply one search result of a network module to the scan cache and
+ * notify listeners and service providers about it
+ *
+ * @param module the network module
+ * @param status #ICD_NW_SEARCH_EXPIRE to remove the network, any other
+ *        status adds or updates it
+ * @param network_name the name of the network
+ * @param network_type the type of the network
+ * @param network_attrs network attributes
+ * @param network_id network id
+ * @param signal signal level
+ * @param station_id base station id
+ * @param dB raw signal strength
+ * @param now current time
+ *
+ */
+static void
+icd_scan_result_apply(struct icd_network_module *module,
+                      enum icd_network_search_status status,
+                      gchar *network_name, gchar *network_type,
+                      const guint network_attrs, gchar *network_id,
+                      enum icd_nw_levels signal, gchar *station_id, gint dB,
+                      guint now)
+{
+  enum icd_scan_status scan_status = ICD_SCAN_NEW;
+  struct icd_scan_cache *cache_entry;
+
+  if (status == ICD_NW_SEARCH_EXPIRE)
+  {
+    struct icd_scan_cache_list *list;
+
+    /* the per network_id list is freed when its last entry is expired */
+    while ((list = icd_scan_cache_list_lookup(module, network_id)))
+    {
+      cache_entry = (struct icd_scan_cache *)list->cache_list->data;
+      icd_scan_cache_entry_expire(module, cache_entry);
+    }
+
+    return;
+  }
+
+  cache_entry = icd_scan_cache_entry_find(module, network_type, network_attrs,
+                                          network_id);
+
+  if (cache_entry)
+  {
+    icd_scan_cache_entry_seen(module, cache_entry, now);
+
+    /* a restored entry seen again is always reported as updated, so that
+       listeners learn that it is no longer stale */
+    if (cache_entry->signal >= signal && !cache_entry->stale)
+    {
+      struct icd_scan_cache new_cache_entry;
+
+      if (icd_scan_cache_entry_notify_due(module, cache_entry,
+                                          ICD_SCAN_NOTIFY, dB, now))
+      {
+        memcpy(&new_cache_entry, cache_entry, sizeof(new_cache_entry));
+        new_cache_entry.station_id = station_id;
+        new_cache_entry.dB = dB;
+        icd_scan_listener_notify(module, NULL, &new_cache_entry,
+                                 ICD_SCAN_NOTIFY);
+      }
+
+      scan_status = ICD_SCAN_NOTIFY;
+    }
+    else
+    {
+      cache_entry->stale = FALSE;
+      cache_entry->signal = signal;
+      cache_entry->dB = dB;
+      icd_scan_cache_entry_set_station(module, cache_entry, station_id);
+      icd_scan_cache_entry_changed(cache_entry);
+      module->scan_churn++;
+
+      if (icd_scan_cache_entry_notify_due(module, cache_entry,
+                                          ICD_SCAN_UPDATE, dB, now))
+      {
+        icd_scan_listener_notify(module, NULL, cache_entry,
+                                 ICD_SCAN_UPDATE);
+      }
+
+      scan_status = ICD_SCAN_UPDATE;
+    }
+  }
+  else
+  {
+    cache_entry = icd_scan_cache_entry_new();
+    cache_entry->network_name = g_strdup(network_name);
+    cache_entry->network_type = (gchar *)icd_string_ref(network_type);
+    cache_entry->network_type_id = icd_scan_network_type_id(network_type);
+    cache_entry->network_attrs = network_attrs;
+    cache_entry->network_id = (gchar *)icd_string_ref(network_id);
+    cache_entry->signal = signal;
+    cache_entry->station_id = g_strdup(station_id);
+    cache_entry->dB = dB;
+    cache_entry->last_seen = now;
+    cache_entry->last_notified = now;
+    cache_entry->notified_dB = dB;
+    cache_entry->network_priority =
+        icd_network_priority_get(NULL, NULL, cache_entry->network_type,
+                                 cache_entry->network_attrs);
+
+    icd_scan_cache_entry_add(module, cache_entry);
+    module->scan_churn++;
+    icd_scan_listener_notify(module, NULL, cache_entry, ICD_SCAN_NEW);
+    scan_status = ICD_SCAN_NEW;
+  }
+
+  icd_srv_provider_identify(module, cache_entry, scan_status);
+}
+
+/**
+ * @brief Finish a search for a single network; only the listeners that asked
+ * for that network are told that the search completed. A full scan requested
+ * meanwhile is started now.
+ *
+ * @param module the network module
+ *
+ */
+static void
+icd_scan_complete_targeted(struct icd_network_module *module)
+{
+  struct icd_scan_cache complete_entry;
+  GSList *l, *m;
+
+  memset(&complete_entry, 0, sizeof(complete_entry));
+
+  for (l = module->network_types; l; l = l->next)
+  {
+    complete_entry.network_type = (gchar *)l->data;
+    complete_entry.network_type_id =
+        icd_scan_network_type_id(complete_entry.network_type);
+    (*icd_scan_notify_serial_get())++;
+
+    for (m = module->scan_listener_list; m; m = m->next)
+    {
+      struct icd_scan_listener *listener = (struct icd_scan_listener *)m->data;
+
+      if (listener && listener->filter &&
+          icd_string_equal(listener->filter->network_id,
+                           module->scan_target_id))
+      {
+        icd_scan_listener_send_entry(NULL, &complete_entry, listener,
+                                     ICD_SCAN_COMPLETE);
+      }
+    }
+  }
+
+  ILOG_INFO("module '%s' scan for network '%s' completed", module->name,
+            module->scan_target_id);
+
+  module->scan_progress = FALSE;
+  module->scan_targeted = FALSE;
+  g_free(module->scan_target_id);
+  module->scan_target_id = NULL;
+
+  if (module->scan_full_pending)
+  {
+    module->scan_full_pending = FALSE;
+    icd_scan_network(module, NULL);
+  }
+  else if (!module->scan_timeout_rescan && icd_scan_listener_exist(module))
+    icd_scan_schedule(module, ICD_SCAN_KEEP);
+}
+
+/**
+ * @brief Complete a scan of a network module: expire old entries, notify
+ * listeners and schedule the next scan
+ *
+ * @param module the network module
+ *
+ */
+static void
+icd_scan_complete(struct icd_network_module *module)
+{
+  struct icd_scan_cache complete_entry;
+  GSList *l;
+
+  icd_scan_cache_expire_entries(module,
+                                time(NULL) - module->nw.search_lifetime);
+
+  if (module->scan_targeted)
+  {
+    icd_scan_complete_targeted(module);
+    return;
+  }
+
+  memset(&complete_entry, 0, sizeof(complete_entry));
+
+  for (l = module->network_types; l; l = l->next)
+  {
+    complete_entry.network_type = (gchar *)l->data;
+    complete_entry.network_type_id =
+        icd_scan_network_type_id(complete_entry.network_type);
+    icd_scan_listener_notify(module, NULL, &complete_entry,
+                             ICD_SCAN_COMPLETE);
+  }
+
+  module->scan_progress = FALSE;
+  ILOG_INFO("module '%s' scan completed", module->name);
+
+  module->scan_last_complete = time(NULL);
+
+  if (icd_network_api_has_search(module))
+  {
+    for (l = module->network_types; l; l = l->next)
+    {
+      if (l->data)
+      {
+        ILOG_INFO("scan stop for type '%s'", (const gchar *)l->data);
+        icd_status_scan_stop((const gchar *)l->data);
+      }
+    }
+  }
+
+  if (!module->scan_churn)
+    icd_scan_schedule(module, ICD_SCAN_BACKOFF);
+  else if (module->scan_churn >= ICD_SCAN_CHURN_SPIKE)
+    icd_scan_schedule(module, ICD_SCAN_RESET);
+  else
+    icd_scan_schedule(module, ICD_SCAN_KEEP);
+
+  module->scan_churn = 0;
+
+  if (module->scan_last_complete >=
+      module->scan_snapshot_saved + ICD_SCAN_SNAPSHOT_INTERVAL)
+    icd_scan_snapshot_save(module);
+}
+
 static void
 icd_scan_cb(enum icd_network_search_status status, gchar *network_name,
             gchar *network_type, const guint network_attrs, gchar *network_id,
@@ -686,200 +1948,461 @@ icd_scan_cb(enum icd_network_search_status status, gchar *network_name,
 {
   struct icd_network_module *module =
       (struct icd_network_module *)search_cb_token;
-  struct icd_scan_cache_list *scan_cache_list;
-  struct icd_scan_cache_timeout *scan_cache_timeout;
-  enum icd_scan_status scan_status = ICD_SCAN_NEW;
-  struct icd_scan_cache *cache_entry = NULL;
+
+  if (!module)
+  {
+    ILOG_ERR("ICd search_cb_token returned from module is NULL");
+    return;
+  }
+
+  if (!module->scan_progress && status != ICD_NW_SEARCH_EXPIRE)
+  {
+    ILOG_INFO("scan results returned from '%s', but no scan ongoing",
+              module->name);
+    return;
+  }
+
+  if (network_name && network_type && network_id)
+  {
+    icd_scan_result_apply(module, status, network_name, network_type,
+                          network_attrs, network_id, signal, station_id, dB,
+                          time(0));
+    icd_srv_provider_identify_flush();
+  }
+  else if (status != ICD_NW_SEARCH_COMPLETE)
+  {
+    ILOG_ERR("returned scan result (%s/%s/%s) has NULL components",
+             network_name, network_type, network_id);
+    return;
+  }
+
+  if (status == ICD_NW_SEARCH_COMPLETE)
+    icd_scan_complete(module);
+}
+
+/**
+ * @brief Batched search callback for network modules; the results are
+ * applied in one pass and the scan is completed once after them if
+ * requested
+ *
+ * @param results array of found networks
+ * @param count number of networks in the array
+ * @param complete TRUE if the search is completed
+ * @param search_cb_token the network module
+ *
+ */
+static void
+icd_scan_batch_cb(const struct icd_nw_search_result *results, guint count,
+                  gboolean complete, const gpointer search_cb_token)
+{
+  struct icd_network_module *module =
+      (struct icd_network_module *)search_cb_token;
+  guint now = time(0);
+  guint dropped = 0;
+  guint i;
+
+  if (!module)
+  {
+    ILOG_ERR("ICd search_cb_token returned from module is NULL");
+    return;
+  }
+
+  for (i = 0; results && i < count; i++)
+  {
+    const struct icd_nw_search_result *result = &results[i];
+
+    if (!module->scan_progress && result->status != ICD_NW_SEARCH_EXPIRE)
+    {
+      dropped++;
+      continue;
+    }
+
+    if (!result->network_name || !result->network_type || !result->network_id)
+    {
+      ILOG_ERR("returned scan result (%s/%s/%s) has NULL components",
+               result->network_name, result->network_type,
+               result->network_id);
+      continue;
+    }
+
+    icd_scan_result_apply(module, result->status, result->network_name,
+                          result->network_type, result->network_attrs,
+                          result->network_id, result->signal,
+                          result->station_id, result->dB, now);
+  }
+
+  icd_srv_provider_identify_flush();
+
+  if (dropped)
+  {
+    ILOG_INFO("%u scan results returned from '%s', but no scan ongoing",
+              dropped, module->name);
+  }
+
+  if (complete && module->scan_progress)
+    icd_scan_complete(module);
+}
+
+/**
+ * @brief Apply all scan results submitted from other threads
+ *
+ */
+static void
+icd_scan_result_queue_drain(void)
+{
+  struct icd_scan_result *head;
+  struct icd_scan_result *results = NULL;
+  guint count = 0;
+
+  do
+  {
+    head = (struct icd_scan_result *)
+        g_atomic_pointer_get(&icd_scan_result_queue);
+  }
+  while (head &&
+         !g_atomic_pointer_compare_and_exchange(&icd_scan_result_queue, head,
+                                                NULL));
+
+  /* the stack has the newest result first */
+  while (head)
+  {
+    struct icd_scan_result *next = head->next;
+
+    head->next = results;
+    results = head;
+    head = next;
+  }
+
+  while (results)
+  {
+    struct icd_scan_result *result = results;
+
+    results = result->next;
+
+    /* the module may have been unloaded after it submitted the result */
+    if (g_slist_find(icd_context_get()->nw_module_list,
+                     result->search_cb_token) &&
+        ((struct icd_network_module *)result->search_cb_token)->
+        scan_cache_table)
+    {
+      icd_scan_cb(result->status, result->network_name, result->network_type,
+                  result->network_attrs, result->network_id, result->signal,
+                  result->station_id, result->dB, result->search_cb_token);
+      count++;
+    }
+    else
+      ILOG_WARN("dropping scan result of unloaded network module");
+
+    g_free(result->network_name);
+    g_free(result->network_type);
+    g_free(result->network_id);
+    g_free(result->station_id);
+    g_free(result);
+  }
+
+  if (count)
+    ILOG_DEBUG("applied %u scan results from other threads", count);
+}
+
+/**
+ * @brief Main loop idle callback applying scan results submitted from
+ * other threads
+ *
+ * @param data not used
+ *
+ * @return FALSE to remove the idle callback
+ *
+ */
+static gboolean
+icd_scan_result_queue_drain_cb(gpointer data)
+{
+  icd_scan_result_queue_drain();
+
+  return FALSE;
+}
+
+/**
+ * @brief Thread safe search callback for network modules; the result is
+ * queued and applied with #icd_scan_cb in the main loop. The first result
+ * queued after a drain schedules the next drain, so results arriving in
+ * quick succession are applied as one batch. Results still queued when the
+ * module is unloaded are dropped.
+ *
+ * @param status the status of the operation
+ * @param network_name the name of the network
+ * @param network_type the type of the network
+ * @param network_attrs network attributes
+ * @param network_id network id
+ * @param signal signal level
+ * @param station_id base station id
+ * @param dB raw signal strength
+ * @param search_cb_token the network module
+ *
+ */
+void
+icd_scan_cb_threaded(enum icd_network_search_status status,
+                     gchar *network_name, gchar *network_type,
+                     const guint network_attrs, gchar *network_id,
+                     enum icd_nw_levels signal, gchar *station_id, gint dB,
+                     const gpointer search_cb_token)
+{
+  struct icd_scan_result *result = g_new0(struct icd_scan_result, 1);
+  gpointer head;
+
+  result->status = status;
+  result->network_name = g_strdup(network_name);
+  result->network_type = g_strdup(network_type);
+  result->network_attrs = network_attrs;
+  result->network_id = g_strdup(network_id);
+  result->signal = signal;
+  result->station_id = g_strdup(station_id);
+  result->dB = dB;
+  result->search_cb_token = search_cb_token;
+
+  do
+  {
+    head = g_atomic_pointer_get(&icd_scan_result_queue);
+    result->next = (struct icd_scan_result *)head;
+  }
+  while (!g_atomic_pointer_compare_and_exchange(&icd_scan_result_queue, head,
+                                                result));
+
+  if (!head)
+    g_idle_add(icd_scan_result_queue_drain_cb, NULL);
+}
+
+/**
+ * @brief Read the scan notification hysteresis, cache size and scan interval
+ * settings for a scan round
+ *
+ * @param module the network module
+ *
+ */
+static void
+icd_scan_settings_load(struct icd_network_module *module)
+{
+  module->scan_db_hysteresis =
+      icd_scan_setting_get(ICD_GCONF_SCAN_DB_HYSTERESIS,
+                           ICD_SCAN_DB_HYSTERESIS_DEFAULT);
+  module->scan_notify_interval =
+      icd_scan_setting_get(ICD_GCONF_SCAN_NOTIFY_INTERVAL,
+                           ICD_SCAN_NOTIFY_INTERVAL_DEFAULT);
+  module->scan_cache_max =
+      icd_scan_setting_get(ICD_GCONF_SCAN_CACHE_MAX,
+                           ICD_SCAN_CACHE_MAX_DEFAULT);
+  module->scan_interval_max =
+      icd_scan_setting_get(ICD_GCONF_SCAN_INTERVAL_MAX, 0);
+}
+
+static gboolean
+icd_scan_network(struct icd_network_module *module, const gchar *network_type)
+{
   GSList *l;
-  guint now;
 
-  if (!module)
+  if (module->scan_progress)
   {
-    ILOG_ERR("ICd search_cb_token returned from module is NULL");
-    return;
+    /* a search for a single network does not cover the other networks */
+    if (module->scan_targeted)
+      module->scan_full_pending = TRUE;
+
+    return TRUE;
   }
 
-  if (!module->scan_progress && status != ICD_NW_SEARCH_EXPIRE)
+  if (!icd_network_api_has_search(module))
   {
-    ILOG_INFO("scan results returned from '%s', but no scan ongoing",
-              module->name);
-    return;
+    ILOG_WARN("module '%s' does not have a scan function", module->name);
+    return FALSE;
   }
 
-  now = time(0);
 
-  if (network_name && network_type && network_id)
+  for (l = module->network_types; l; l = l->next)
   {
-    scan_cache_list = icd_scan_cache_list_lookup(module, network_id);
-
-    if (scan_cache_list)
+    if (l->data)
     {
-      cache_entry = icd_scan_cache_entry_find(scan_cache_list, network_type,
-                                              network_attrs);
-
-      if (status == ICD_NW_SEARCH_EXPIRE)
-      {
-        struct icd_scan_expire_network_data user_data;
+      ILOG_INFO("scan start for type '%s'", (const gchar *)l->data);
+      icd_status_scan_start((const gchar *)l->data);
+    }
+  }
 
-        user_data.module = module;
-        user_data.expire = now;
-        icd_scan_expire_network(network_id, scan_cache_list, &user_data);
-        return;
-      }
+  icd_scan_settings_load(module);
+  module->scan_progress = TRUE;
 
-      if (cache_entry)
-      {
-        cache_entry->last_seen = now;
+  if (module->nw.start_search_batch)
+  {
+    module->nw.start_search_batch(NULL, module->scope, icd_scan_batch_cb,
+                                  module, &module->nw.private);
+  }
+  else
+  {
+    module->nw.start_search(NULL, module->scope, icd_scan_cb, module,
+                            &module->nw.private);
+  }
 
-        if (cache_entry->signal >= signal)
-        {
-          struct icd_scan_cache new_cache_entry;
-
-          memcpy(&new_cache_entry, cache_entry, sizeof(new_cache_entry));
-          new_cache_entry.station_id = station_id;
-          new_cache_entry.dB = dB;
-          icd_scan_listener_notify(module, NULL, &new_cache_entry,
-                                   ICD_SCAN_NOTIFY);
-          scan_status = ICD_SCAN_NOTIFY;
-        }
-        else
-        {
-          cache_entry->signal = signal;
-          cache_entry->dB = dB;
-          g_free(cache_entry->station_id);
-          cache_entry->station_id = g_strdup(station_id);
-          icd_scan_listener_notify(module, NULL, cache_entry,
-                                   ICD_SCAN_UPDATE);
-          scan_status = ICD_SCAN_UPDATE;
-        }
-      }
-    }
+  return TRUE;
+}
 
-    if (!cache_entry)
+/**
+ * @brief Search for a single network; the scan status is not shown to the
+ * user and the scan interval is not affected
+ *
+ * @param module the network module
+ * @param network_type network type
+ * @param network_id network id
+ * @param scope scan scope
+ *
+ * @return TRUE if a scan is ongoing, FALSE otherwise
+ *
+ */
+static gboolean
+icd_scan_network_id(struct icd_network_module *module,
+                    const gchar *network_type, const gchar *network_id,
+                    const guint scope)
+{
+  if (module->scan_progress)
+  {
+    /* another network is being searched for, search for all of them */
+    if (module->scan_targeted &&
+        !icd_string_equal(module->scan_target_id, network_id))
     {
-      cache_entry = g_new0(struct icd_scan_cache, 1);
-      cache_entry->network_name = g_strdup(network_name);
-      cache_entry->network_type = g_strdup(network_type);
-      cache_entry->network_attrs = network_attrs;
-      cache_entry->network_id = g_strdup(network_id);
-      cache_entry->signal = signal;
-      cache_entry->station_id = g_strdup(station_id);
-      cache_entry->dB = dB;
-      cache_entry->last_seen = now;
-      cache_entry->network_priority =
-          icd_network_priority_get(NULL, NULL, cache_entry->network_type,
-                                   cache_entry->network_attrs);
-
-      if (!scan_cache_list)
-        scan_cache_list = g_new0(struct icd_scan_cache_list, 1);
-
-      icd_scan_cache_entry_add(module, scan_cache_list, cache_entry);
-      icd_scan_listener_notify(module, NULL, cache_entry, ICD_SCAN_NEW);
-      scan_status = ICD_SCAN_NEW;
+      module->scan_full_pending = TRUE;
     }
 
-    icd_srv_provider_identify(module, cache_entry, scan_status);
-
-    if (status != ICD_NW_SEARCH_COMPLETE)
-      return;
+    return TRUE;
   }
 
-  if (status == ICD_NW_SEARCH_COMPLETE)
-  {
-    struct icd_scan_expire_network_data user_data;
+  ILOG_INFO("module '%s' scan start for network '%s'", module->name,
+            network_id);
 
-    user_data.module = module;
-    user_data.expire = time(NULL) - module->nw.search_lifetime;
-    g_hash_table_foreach_remove(module->scan_cache_table,
-                                (GHRFunc)icd_scan_expire_network_for_hash,
-                                &user_data);
+  icd_scan_settings_load(module);
+  module->scan_progress = TRUE;
+  module->scan_targeted = TRUE;
+  module->scan_target_id = g_strdup(network_id);
+  module->nw.start_search_id(network_type, network_id, scope, icd_scan_cb,
+                             module, &module->nw.private);
 
-    cache_entry = g_new0(struct icd_scan_cache, 1);
+  return TRUE;
+}
 
-    for (l = module->network_types; l; l = l->next)
-    {
-      cache_entry->network_type = (gchar *)l->data;
-      icd_scan_listener_notify(module, NULL, cache_entry,
-                               ICD_SCAN_COMPLETE);
-    }
+/**
+ * @brief Check whether the scan cache of a module has networks recent enough
+ * to be used without starting a new scan, e.g. when connecting
+ *
+ * @param module the network module
+ * @param type network type or NULL for all types
+ * @param scope requested scan scope
+ * @param filter scan result filter or NULL
+ *
+ * @return TRUE if a network of the type passing the filter was seen recently
+ * by a scan of at least the requested scope, FALSE otherwise
+ *
+ */
+static gboolean
+icd_scan_cache_is_fresh(struct icd_network_module *module, const gchar *type,
+                        const guint scope, const struct icd_scan_filter *filter)
+{
+  GHashTableIter iter;
+  gpointer value;
+  gint fresh_age;
+  guint oldest;
 
-    g_free(cache_entry);
-    module->scan_progress = FALSE;
-    ILOG_INFO("module '%s' scan completed", module->name);
+  if (module->scan_progress || module->scope > scope ||
+      !icd_scan_cache_has_elements(module))
+    return FALSE;
 
-    if (module->nw.start_search)
-    {
-      for (l = module->network_types; l; l = l->next)
-      {
-        if (l->data)
-        {
-          ILOG_INFO("scan stop for type '%s'", (const gchar *)l->data);
-          icd_status_scan_stop((const gchar *)l->data);
-        }
-      }
-    }
+  fresh_age = icd_gconf_get_iap_int_default(NULL, ICD_GCONF_SCAN_FRESH_AGE,
+                                            ICD_SCAN_FRESH_AGE_DEFAULT);
 
-    if (module->scan_timeout_rescan)
-      g_source_remove(module->scan_timeout_rescan);
+  if (fresh_age <= 0)
+    return FALSE;
+
+  oldest = time(NULL) - fresh_age;
+  g_hash_table_iter_init(&iter, module->scan_cache_table);
 
-    module->scan_timeout_rescan =
-        g_timeout_add(1000 * module->nw.search_interval,
-                      icd_scan_cache_rescan, module);
+  while (g_hash_table_iter_next(&iter, NULL, &value))
+  {
+    struct icd_scan_cache *cache_entry = (struct icd_scan_cache *)value;
 
-    scan_cache_timeout = g_new0(struct icd_scan_cache_timeout, 1);
-    scan_cache_timeout->module = module;
+    if (cache_entry->stale || cache_entry->last_seen < oldest)
+      continue;
 
-    scan_cache_timeout->id =
-        g_timeout_add(1000 * module->nw.search_lifetime,
-                      icd_scan_cache_expire, scan_cache_timeout);
+    if (type && strncmp(type, cache_entry->network_type, strlen(type)))
+      continue;
 
-    module->scan_timeout_list =
-        g_slist_prepend(module->scan_timeout_list, scan_cache_timeout);
+    if (scope == ICD_NW_SEARCH_SCOPE_SAVED &&
+        !(cache_entry->network_attrs & ICD_NW_ATTR_IAPNAME))
+      continue;
 
-    return;
+    if (icd_scan_filter_match_network(filter, cache_entry))
+      return TRUE;
   }
 
-  ILOG_ERR("returned scan result (%s/%s/%s) has NULL components", network_name,
-           network_type, network_id);
+  return FALSE;
 }
 
-static gboolean
-icd_scan_network(struct icd_network_module *module, const gchar *network_type)
+/**
+ * @brief Check whether the network of a saved IAP was seen recently enough
+ * by a scan to be connected without searching for it first
+ *
+ * @param network_type network type
+ * @param network_id network id
+ *
+ * @return TRUE if the network is fresh in a scan cache, FALSE otherwise
+ *
+ */
+gboolean
+icd_scan_cache_network_is_fresh(const gchar *network_type,
+                                const gchar *network_id)
 {
+  struct icd_scan_filter filter;
   GSList *l;
 
-  if (module->scan_progress)
-    return TRUE;
-
-  if (!module->nw.start_search)
-  {
-    ILOG_WARN("module '%s' does not have a scan function", module->name);
+  if (!network_type || !network_id)
     return FALSE;
-  }
 
+  memset(&filter, 0, sizeof(filter));
+  filter.network_id = (gchar *)network_id;
 
-  for (l = module->network_types; l; l = l->next)
+  for (l = icd_context_get()->nw_module_list; l; l = l->next)
   {
-    if (l->data)
+    struct icd_network_module *module = (struct icd_network_module *)l->data;
+
+    if (module && icd_network_api_has_type(module, network_type) &&
+        icd_scan_cache_is_fresh(module, network_type,
+                                ICD_NW_SEARCH_SCOPE_SAVED, &filter))
     {
-      ILOG_INFO("scan start for type '%s'", (const gchar *)l->data);
-      icd_status_scan_start((const gchar *)l->data);
+      return TRUE;
     }
   }
 
-  module->scan_progress = TRUE;
-  module->nw.start_search(NULL, module->scope, icd_scan_cb, module,
-                          &module->nw.private);
-
-  return TRUE;
+  return FALSE;
 }
 
+/**
+ * @brief Request scan results from all network modules supporting the type;
+ * the results are given to the callback only if they pass the filter
+ *
+ * @param type network type or NULL for all types
+ * @param scope scan scope
+ * @param filter scan result filter, copied; NULL to receive all results
+ * @param allow_cached TRUE if matching networks seen by a scan moments ago
+ * are good enough and no new scan needs to be started; ignored when
+ * aggressive scanning is configured
+ * @param cb callback for scan results
+ * @param user_data user data for the callback
+ *
+ * @return TRUE if a network module supporting the type was found, FALSE
+ * otherwise
+ *
+ */
 gboolean
-icd_scan_results_request(const gchar *type, const guint scope,
-                         icd_scan_cb_fn cb, gpointer user_data)
+icd_scan_results_request_filtered(const gchar *type, const guint scope,
+                                  const struct icd_scan_filter *filter,
+                                  const gboolean allow_cached,
+                                  icd_scan_cb_fn cb, gpointer user_data)
 {
   GSList *l, *m;
   gboolean rv = FALSE;
+  gboolean aggressive = icd_gconf_agressive_scanning();
 
   if (!cb)
   {
@@ -897,10 +2420,12 @@ icd_scan_results_request(const gchar *type, const guint scope,
       ILOG_ERR("network module in list is NULL");
       continue;
     }
-    if (module->nw.start_search &&
+    if (icd_network_api_has_search(module) &&
         (!type || icd_network_api_has_type(module, type)))
     {
       gboolean scan_listener_exist = icd_scan_listener_exist(module);
+      gboolean fresh = allow_cached && !aggressive &&
+          icd_scan_cache_is_fresh(module, type, scope, filter);
 
       for (m = module->scan_listener_list; m; m = m->next)
       {
@@ -927,27 +2452,53 @@ icd_scan_results_request(const gchar *type, const guint scope,
         listener->cb = cb;
         listener->user_data = user_data;
         listener->type = g_strdup(type);
+        listener->type_mask = icd_network_api_type_prefix_mask(type);
+
+        if (filter)
+        {
+          listener->filter = g_new(struct icd_scan_filter, 1);
+          *listener->filter = *filter;
+          listener->filter->service_type = g_strdup(filter->service_type);
+          listener->filter->network_id = g_strdup(filter->network_id);
+        }
+
         module->scan_listener_list =
             g_slist_prepend(module->scan_listener_list, listener);
+        icd_scan_listener_dispatch_add(module, listener);
+
+        if (module->scan_timeout_rescan &&
+            module->scan_interval != module->nw.search_interval)
+        {
+          icd_scan_schedule(module, ICD_SCAN_RESET);
+        }
 
         if (icd_scan_cache_has_elements(module))
         {
           g_hash_table_foreach(module->scan_cache_table, icd_scan_listener_send_list, listener);
 
-          if (module->scan_timeout_rescan)
+          if (module->scan_timeout_rescan || fresh)
           {
             struct icd_scan_cache cache_entry;
 
             memset (&cache_entry, 0, sizeof(cache_entry));
             cache_entry.network_type = listener->type;
+            (*icd_scan_notify_serial_get())++;
             icd_scan_listener_send_entry(NULL, &cache_entry, listener, ICD_SCAN_COMPLETE);
           }
         }
       }
 
-      if ((!scan_listener_exist && !module->scan_timeout_rescan) ||
-          module->scope > scope || !icd_scan_cache_has_elements(module) ||
-          icd_gconf_get_iap_bool(NULL, ICD_GCONF_AGGRESSIVE_SCANNING, FALSE))
+      if (fresh)
+      {
+        ILOG_DEBUG("module '%s' scan cache is fresh, not scanning",
+                   module->name);
+      }
+      else if (filter && filter->network_id && type &&
+               module->nw.start_search_id)
+        icd_scan_network_id(module, type, filter->network_id, scope);
+      else if ((!scan_listener_exist && !module->scan_timeout_rescan) ||
+               module->scope > scope || !icd_scan_cache_has_elements(module) ||
+               aggressive)
       {
         module->scope = scope;
         icd_scan_network(module, NULL);
@@ -963,38 +2514,276 @@ icd_scan_results_request(const gchar *type, const guint scope,
   return rv;
 }
 
+/**
+ * @brief Check whether a single network of a type can be searched for
+ * without scanning for all networks
+ *
+ * @param type network type
+ *
+ * @return TRUE if a network module supporting the type can search for a
+ * single network, FALSE otherwise
+ *
+ */
+gboolean
+icd_scan_network_id_supported(const gchar *type)
+{
+  GSList *l;
+
+  if (!type)
+    return FALSE;
+
+  for (l = icd_context_get()->nw_module_list; l; l = l->next)
+  {
+    struct icd_network_module *module = (struct icd_network_module *)l->data;
+
+    if (module && module->nw.start_search_id &&
+        icd_network_api_has_search(module) &&
+        icd_network_api_has_type(module, type))
+    {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+ * @brief Request all scan results from all network modules supporting the
+ * type
+ *
+ * @param type network type or NULL for all types
+ * @param scope scan scope
+ * @param cb callback for scan results
+ * @param user_data user data for the callback
+ *
+ * @return TRUE if a network module supporting the type was found, FALSE
+ * otherwise
+ *
+ */
+gboolean
+icd_scan_results_request(const gchar *type, const guint scope,
+                         icd_scan_cb_fn cb, gpointer user_data)
+{
+  return icd_scan_results_request_filtered(type, scope, NULL, FALSE, cb,
+                                           user_data);
+}
+
+/**
+ * @brief Add a cache entry to the scan cache; an entry with the same network
+ * type, attributes and id must not already exist in the cache
+ *
+ * @param module the network module
+ * @param cache_entry the cache entry to add
+ *
+ */
 void
 icd_scan_cache_entry_add(struct icd_network_module *module,
-                         struct icd_scan_cache_list *scan_cache,
                          struct icd_scan_cache *cache_entry)
 {
-  if (module && scan_cache && cache_entry)
+  if (!module || !module->scan_cache_table || !cache_entry)
+  {
+    ILOG_ERR("module, cache table or cache not given when adding scan");
+    return;
+  }
+
+  while (module->scan_cache_max &&
+         g_queue_get_length(module->scan_expire_queue) >=
+         module->scan_cache_max)
   {
-    scan_cache->cache_list = g_slist_prepend(scan_cache->cache_list,
-                                             cache_entry);
-    g_hash_table_replace(module->scan_cache_table,
-                         g_strdup(cache_entry->network_id), scan_cache);
+    if (!icd_scan_cache_evict(module))
+      break;
   }
-  else
-    ILOG_ERR("module, cache list or cache not given when adding scan");
+
+  icd_scan_cache_entry_changed(cache_entry);
+  g_hash_table_insert(module->scan_cache_table, cache_entry, cache_entry);
+  g_queue_push_tail(module->scan_expire_queue, cache_entry);
+  cache_entry->expire_link = g_queue_peek_tail_link(module->scan_expire_queue);
+
+  icd_scan_cache_view_add(module->scan_cache_id_table,
+                          cache_entry->network_id, cache_entry);
+
+  if (cache_entry->network_attrs & ICD_NW_ATTR_IAPNAME)
+  {
+    icd_scan_cache_view_add(module->scan_cache_iap_table,
+                            cache_entry->network_id, cache_entry);
+  }
+
+  icd_scan_cache_view_add(module->scan_cache_station_table,
+                          cache_entry->station_id, cache_entry);
+
+  icd_scan_cache_expire_arm(module);
 }
 
+/**
+ * @brief Find a cache entry
+ *
+ * @param module the network module
+ * @param network_type network type
+ * @param network_attrs network attributes
+ * @param network_id network id
+ *
+ * @return the cache entry or NULL if not found
+ *
+ */
 struct icd_scan_cache *
-icd_scan_cache_entry_find(struct icd_scan_cache_list *scan_cache_list,
-                          const gchar *network_type, const guint network_attrs)
+icd_scan_cache_entry_find(struct icd_network_module *module,
+                          const gchar *network_type,
+                          const guint network_attrs,
+                          const gchar *network_id)
+{
+  struct icd_scan_cache key;
+
+  if (!module || !module->scan_cache_table)
+    return NULL;
+
+  /* cached network types and ids are interned, so a string that is not
+     interned cannot be in the cache */
+  key.network_type = (gchar *)icd_string_lookup(network_type);
+  key.network_attrs = network_attrs;
+  key.network_id = (gchar *)icd_string_lookup(network_id);
+
+  if (!key.network_type || !key.network_id)
+    return NULL;
+
+  return (struct icd_scan_cache *)
+      g_hash_table_lookup(module->scan_cache_table, &key);
+}
+
+/**
+ * @brief Give a cache entry and its service providers to a callback
+ *
+ * @param cache_entry the cache entry
+ * @param status status to report
+ * @param cb the callback
+ * @param user_data user data for the callback
+ *
+ */
+static void
+icd_scan_cache_changes_send(struct icd_scan_cache *cache_entry,
+                            enum icd_scan_status status,
+                            icd_scan_cb_fn cb,
+                            gpointer user_data)
 {
   GSList *l;
 
-  for (l = scan_cache_list->cache_list; l; l = l->next)
+  if (!(cache_entry->network_attrs & ICD_NW_ATTR_SRV_PROVIDER))
+    cb(status, NULL, cache_entry, user_data);
+
+  for (l = cache_entry->srv_provider_list; l; l = l->next)
   {
-    struct icd_scan_cache *cache_entry = (struct icd_scan_cache *)l->data;
+    if (l->data)
+      cb(status, (struct icd_scan_srv_provider *)l->data, cache_entry,
+         user_data);
+  }
+}
+
+/**
+ * @brief Give all scan cache changes made after a generation to a callback;
+ * added and updated entries are reported with #ICD_SCAN_UPDATE and removed
+ * ones with #ICD_SCAN_EXPIRE. If the generation is from another ICd2 instance
+ * or the change history does not reach back to it, all cached entries are
+ * reported with #ICD_SCAN_NEW instead
+ *
+ * @param epoch epoch the generation belongs to
+ * @param generation generation the caller is up to date with, 0 for all
+ * @param cb the callback
+ * @param user_data user data for the callback
+ *
+ * @return TRUE if only the changes were reported, FALSE if a full snapshot of
+ * the scan cache was reported
+ *
+ */
+gboolean
+icd_scan_cache_changes(const guint epoch, const guint generation,
+                       icd_scan_cb_fn cb, gpointer user_data)
+{
+  struct icd_scan_history *history = icd_scan_history_get();
+  gboolean delta = epoch == history->epoch && generation != 0 &&
+      generation >= history->dropped && generation <= history->generation;
+  GSList *l;
+  GList *m;
+
+  for (l = icd_context_get()->nw_module_list; l; l = l->next)
+  {
+    struct icd_network_module *module = (struct icd_network_module *)l->data;
+    GHashTableIter iter;
+    gpointer value;
+
+    if (!module || !module->scan_cache_table)
+      continue;
+
+    g_hash_table_iter_init(&iter, module->scan_cache_table);
 
-    if (cache_entry && cache_entry->network_attrs == network_attrs &&
-        string_equal(cache_entry->network_type, network_type))
+    while (g_hash_table_iter_next(&iter, NULL, &value))
     {
-      return cache_entry;
+      struct icd_scan_cache *cache_entry = (struct icd_scan_cache *)value;
+
+      if (!delta)
+        icd_scan_cache_changes_send(cache_entry, ICD_SCAN_NEW, cb, user_data);
+      else if (cache_entry->generation > generation)
+        icd_scan_cache_changes_send(cache_entry, ICD_SCAN_UPDATE, cb,
+                                    user_data);
     }
   }
 
-  return NULL;
+  if (!delta)
+    return FALSE;
+
+  for (m = history->expired->head; m; m = m->next)
+  {
+    struct icd_scan_cache *expired = (struct icd_scan_cache *)m->data;
+
+    if (expired->generation > generation)
+      cb(ICD_SCAN_EXPIRE, NULL, expired, user_data);
+  }
+
+  return TRUE;
+}
+
+/**
+ * @brief Give the cached networks to a callback without starting a scan; the
+ * networks are reported with #ICD_SCAN_NEW
+ *
+ * @param type network type or NULL for all types
+ * @param max_age maximum seconds since the network was last seen or 0 for
+ * any age
+ * @param cb the callback
+ * @param user_data user data for the callback
+ *
+ */
+void
+icd_scan_cache_foreach(const gchar *type, const guint max_age,
+                       icd_scan_cb_fn cb, gpointer user_data)
+{
+  guint oldest = 0;
+  GSList *l;
+
+  if (max_age)
+    oldest = time(NULL) - max_age;
+
+  for (l = icd_context_get()->nw_module_list; l; l = l->next)
+  {
+    struct icd_network_module *module = (struct icd_network_module *)l->data;
+    GHashTableIter iter;
+    gpointer value;
+
+    if (!module || !module->scan_cache_table ||
+        (type && !icd_network_api_has_type(module, type)))
+      continue;
+
+    g_hash_table_iter_init(&iter, module->scan_cache_table);
+
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+      struct icd_scan_cache *cache_entry = (struct icd_scan_cache *)value;
+
+      if (cache_entry->last_seen < oldest)
+        continue;
+
+      if (type && strncmp(type, cache_entry->network_type, strlen(type)))
+        continue;
+
+      icd_scan_cache_changes_send(cache_entry, ICD_SCAN_NEW, cb, user_data);
+    }
+  }
 }
@@ -6,8 +6,10 @@
 #include "network_api.h"
 #include "dbus_api.h"
 
-/** scan cache hash table elements defined like this because we need to update
- *  the GSList pointer when elements are removed
+struct icd_network_module;
+
+/** per network_id view of the scan cache; hash table elements defined like
+ *  this because we need to update the GSList pointer when elements are removed
  */
 struct icd_scan_cache_list {
   /** list of #icd_scan_cache elements */
@@ -63,18 +65,67 @@ struct icd_scan_cache {
 
   /** #icd_scan_srv_provider list of service providers for this network */
   GSList *srv_provider_list;
+
+  /** link in #icd_network_module.scan_expire_queue, which is kept in
+   *  last_seen order */
+  GList *expire_link;
+
+  /** scan cache generation of the last change to this entry */
+  guint generation;
+
+  /** network type id from the network type registry */
+  guint network_type_id;
+  /** time when listeners were last notified about this entry */
+  guint last_notified;
+
+  /** raw signal strength listeners were last notified about */
+  gint notified_dB;
+
+  /** entry was restored from a snapshot and not yet confirmed by a scan */
+  gboolean stale;
+
+  /** service modules that already answered for this network, either as
+   *  unknown or with a service provider on this entry; they are not asked
+   *  again while the entry is cached */
+  GSList *srv_identified_list;
 };
 
-/** #icd_network_module.scan_timeout_list data. Cache expiry callbacks and
- *  rescan callbacks will be queued with a pointer to this element with id field
- *  containing the glib timeout id
- */
-struct icd_scan_cache_timeout {
-  /** (back)pointer to the network module */
-  struct icd_network_module *module;
+/** scan result filter applied before results are given to a listener */
+struct icd_scan_filter {
+  /** minimum signal level of the network */
+  enum icd_nw_levels min_signal;
 
-  /** timeout id */
-  guint id;
+  /** network attributes that must all be set */
+  guint attrs_required;
+
+  /** network attributes that must not be set */
+  guint attrs_forbidden;
+
+  /** service type the result must have or NULL for any */
+  gchar *service_type;
+
+  /** only networks with a saved IAP, i.e. #ICD_NW_ATTR_IAPNAME set */
+  gboolean saved_only;
+
+  /** network id the result must have or NULL for any; if set, network
+   *  modules supporting it search only for this network */
+  gchar *network_id;
+};
+
+/** scan cache record allocation counters */
+struct icd_scan_alloc_stats {
+  /** cache entries currently allocated */
+  guint cache_entries;
+  /** cache entries allocated since startup */
+  guint cache_entries_total;
+  /** service provider records currently allocated */
+  guint srv_providers;
+  /** service provider records allocated since startup */
+  guint srv_providers_total;
+  /** service provider identify requests currently pending */
+  guint identifies;
+  /** service provider identify requests allocated since startup */
+  guint identifies_total;
 };
 
 /**
@@ -94,22 +145,57 @@ typedef void
                    const struct icd_scan_cache *cache_entry,
                    gpointer user_data);
 
+guint icd_scan_network_type_id (const gchar *network_type);
+
+struct icd_scan_cache *icd_scan_cache_entry_new (void);
+struct icd_scan_srv_provider *icd_scan_srv_provider_new (void);
 void icd_scan_cache_entry_free (struct icd_scan_cache *cache_entry);
+struct icd_scan_alloc_stats *icd_scan_alloc_stats_get (void);
 
 void icd_scan_cache_entry_add (struct icd_network_module *module,
-                               struct icd_scan_cache_list *scan_cache,
                                struct icd_scan_cache *cache_entry);
 
+void icd_scan_cb_threaded (enum icd_network_search_status status,
+                           gchar *network_name,
+                           gchar *network_type,
+                           const guint network_attrs,
+                           gchar *network_id,
+                           enum icd_nw_levels signal,
+                           gchar *station_id,
+                           gint dB,
+                           const gpointer search_cb_token);
+
 struct icd_scan_cache_list *
 icd_scan_cache_list_lookup (struct icd_network_module *module,
                             const gchar *network_id);
 
+struct icd_scan_cache_list *
+icd_scan_cache_station_lookup (struct icd_network_module *module,
+                               const gchar *station_id);
+
 struct icd_scan_cache *
-icd_scan_cache_entry_find (struct icd_scan_cache_list *scan_cache_list,
+icd_scan_cache_entry_find (struct icd_network_module *module,
                            const gchar *network_type,
-                           const guint network_attrs);
+                           const guint network_attrs,
+                           const gchar *network_id);
+
+void icd_scan_cache_entry_changed (struct icd_scan_cache *cache_entry);
+
+guint icd_scan_cache_epoch (void);
 
-gboolean icd_scan_cache_entry_remove(struct icd_scan_cache_list *scan_cache_list,
+guint icd_scan_cache_generation (void);
+
+gboolean icd_scan_cache_changes (const guint epoch,
+                                 const guint generation,
+                                 icd_scan_cb_fn cb,
+                                 gpointer user_data);
+
+void icd_scan_cache_foreach (const gchar *type,
+                             const guint max_age,
+                             icd_scan_cb_fn cb,
+                             gpointer user_data);
+
+gboolean icd_scan_cache_entry_remove(struct icd_network_module *module,
                                      const gchar *network_id,
                                      const gchar *network_type,
                                      const guint network_attrs);
@@ -119,14 +205,27 @@ void icd_scan_listener_notify (struct icd_network_module *module,
                                struct icd_scan_cache *cache_entry,
                                enum icd_scan_status status);
 
+guint icd_scan_listener_notify_serial (void);
+
 gboolean icd_scan_results_request (const gchar *type,
                                    const guint scope,
                                    icd_scan_cb_fn cb,
                                    gpointer user_data);
+gboolean
+icd_scan_results_request_filtered (const gchar *type,
+                                   const guint scope,
+                                   const struct icd_scan_filter *filter,
+                                   const gboolean allow_cached,
+                                   icd_scan_cb_fn cb,
+                                   gpointer user_data);
 gboolean icd_scan_results_unregister (icd_scan_cb_fn cb,
                                       gpointer user_data);
+gboolean icd_scan_network_id_supported (const gchar *type);
+gboolean icd_scan_cache_network_is_fresh (const gchar *network_type,
+                                          const gchar *network_id);
 gboolean icd_scan_cache_init (struct icd_network_module *module);
 void icd_scan_cache_remove (struct icd_network_module *module);
+void icd_scan_cache_restore (struct icd_network_module *module);
 
 void icd_scan_cache_remove_iap(gchar *iap_name);
 
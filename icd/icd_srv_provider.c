@@ -11,6 +11,7 @@
 #include "icd_status.h"
 #include "icd_network_priority.h"
 #include "icd_version.h"
+#include "icd_string.h"
 
 /** service provider entry for the module name */
 #define ICD_SRV_PROVIDER_MODULE_NAME   "/module"
@@ -45,29 +46,19 @@ struct icd_srv_identify {
 
   /** the signal level */
   enum icd_nw_levels signal;
-};
 
-/**
- * @brief Helper function for comparing two strings where a NULL string is equal
- * to another NULL string
- *
- * @param a string A
- * @param b string B
- *
- * @return TRUE if equal, FALSE if unequal
- *
- */
-inline static gboolean
-string_equal(const char *a, const char *b)
-{
-  if (!a)
-    return !b;
+  /** the service module asked */
+  struct icd_srv_module *srv_module;
 
-  if (b)
-    return !strcmp(a, b);
+  /** interned network type of the cache entry to identify */
+  const gchar *network_type;
 
-  return FALSE;
-}
+  /** network attributes of the cache entry to identify */
+  guint network_attrs;
+
+  /** interned network id of the cache entry to identify */
+  const gchar *network_id;
+};
 
 static gboolean
 icd_srv_provider_foreach_module_pid(struct icd_srv_module *srv_module,
@@ -346,6 +337,14 @@ icd_srv_provider_init(const gchar *module_name, void *handle,
     if (init(&module->srv, icd_srv_provider_watch_pid, module,
                       icd_srv_provider_close, icd_srv_provider_limited_conn))
     {
+      if (module->srv.identify_batch && module->srv.version &&
+          icd_version_compare(module->srv.version, "0.89") < 0)
+      {
+        ILOG_WARN("Service module '%s' version %s compiled against API < 0.89, not using batched identify",
+                  module_name, module->srv.version);
+        module->srv.identify_batch = NULL;
+      }
+
       if (module->srv.version)
       {
         if (module->srv.identify)
@@ -365,6 +364,7 @@ icd_srv_provider_init(const gchar *module_name, void *handle,
                 if (network_type)
                 {
                   GSList *nw_type_to_srv;
+                  struct icd_network_type *type;
 
                   ILOG_INFO("service provider module %p '%s', network type '%s'",
                             module, module->name, network_type);
@@ -375,6 +375,14 @@ icd_srv_provider_init(const gchar *module_name, void *handle,
                   g_hash_table_insert(data->icd_ctx->nw_type_to_srv_module,
                                       g_strdup(network_type),
                                       g_slist_prepend(nw_type_to_srv, module));
+
+                  type = icd_network_api_type_get(network_type);
+
+                  if (type)
+                  {
+                    type->srv_module_list =
+                        g_slist_prepend(type->srv_module_list, module);
+                  }
                 }
               }
 
@@ -531,6 +539,15 @@ icd_srv_provider_load_modules(struct icd_context *icd_ctx)
 static void
 icd_srv_provider_free_list(gpointer key, gpointer value, gpointer user_data)
 {
+  struct icd_network_type *type =
+      icd_network_api_type_get((const gchar *)key);
+
+  if (type)
+  {
+    g_slist_free(type->srv_module_list);
+    type->srv_module_list = NULL;
+  }
+
   g_slist_free((GSList *)value);
 }
 
@@ -577,12 +594,62 @@ icd_srv_provider_unload_modules(struct icd_context *icd_ctx)
   {
     g_hash_table_foreach(icd_ctx->nw_type_to_srv_module,
                          icd_srv_provider_free_list, NULL);
+
     g_hash_table_destroy(icd_ctx->nw_type_to_srv_module);
   }
 
   icd_ctx->nw_type_to_srv_module = NULL;
 }
 
+/**
+ * @brief Free service identification information
+ *
+ * @param identify the identification information
+ *
+ */
+static void
+icd_srv_provider_identify_free(struct icd_srv_identify *identify)
+{
+  icd_string_unref(identify->network_type);
+  icd_string_unref(identify->network_id);
+  g_slice_free(struct icd_srv_identify, identify);
+  icd_scan_alloc_stats_get()->identifies--;
+}
+
+/**
+ * @brief Record on the identified network that the service module has
+ * answered, so that it is not asked again until the entry expires. A network
+ * with different attributes is a different cache entry and is identified
+ * anew.
+ *
+ * @param identify the identification information
+ * @param srv_entry the cache entry the service provider was added to or NULL
+ *        if the network was not identified
+ *
+ */
+static void
+icd_srv_provider_identified(struct icd_srv_identify *identify,
+                            struct icd_scan_cache *srv_entry)
+{
+  struct icd_scan_cache *cache_entry =
+      icd_scan_cache_entry_find(identify->module, identify->network_type,
+                                identify->network_attrs, identify->network_id);
+
+  if (!cache_entry)
+    return;
+
+  /* a provider on a separate entry is only kept up to date by asking the
+     service module again */
+  if (srv_entry && srv_entry != cache_entry)
+    return;
+
+  if (!g_slist_find(cache_entry->srv_identified_list, identify->srv_module))
+  {
+    cache_entry->srv_identified_list =
+        g_slist_prepend(cache_entry->srv_identified_list, identify->srv_module);
+  }
+}
+
 static void
 icd_srv_provider_identify_cb(const enum icd_srv_identify_status status,
                              const gchar *service_type,
@@ -597,8 +664,7 @@ icd_srv_provider_identify_cb(const enum icd_srv_identify_status status,
 {
   struct icd_srv_identify *identify =
       (struct icd_srv_identify *)identify_cb_token;
-  struct icd_scan_cache_list *scan_cache;
-  struct icd_scan_cache *cache_entry = NULL;
+  struct icd_scan_cache *cache_entry;
   struct icd_scan_srv_provider *provider;
   GSList *l;
 
@@ -609,7 +675,12 @@ icd_srv_provider_identify_cb(const enum icd_srv_identify_status status,
   }
 
   if (status == ICD_SRV_UNKNOWN)
+  {
+    /* remember the outcome so that the service module is not asked again
+       about every sighting of the network */
+    icd_srv_provider_identified(identify, NULL);
     goto stop_identify;
+  }
 
   if (!service_type || !service_id)
   {
@@ -625,39 +696,32 @@ icd_srv_provider_identify_cb(const enum icd_srv_identify_status status,
     goto out;
   }
 
-  scan_cache = icd_scan_cache_list_lookup(identify->module, network_id);
+  cache_entry = icd_scan_cache_entry_find(identify->module, network_type,
+                                          network_attrs, network_id);
 
-  if (!scan_cache)
+  if (!cache_entry)
   {
-    ILOG_DEBUG("srv provider created cache list");
-    scan_cache = g_new0(struct icd_scan_cache_list, 1);
-    goto create_entry;
+    cache_entry =
+        icd_scan_cache_entry_find(identify->module, network_type,
+                                  network_attrs | ICD_NW_ATTR_SRV_PROVIDER,
+                                  network_id);
   }
 
-  cache_entry =
-      icd_scan_cache_entry_find(scan_cache, network_type, network_attrs);
-
   if (!cache_entry)
   {
-    cache_entry =
-        icd_scan_cache_entry_find(scan_cache, network_type,
-                                  network_attrs | ICD_NW_ATTR_SRV_PROVIDER);
-
-    if (!cache_entry)
-    {
-create_entry:
-      cache_entry = g_new0(struct icd_scan_cache, 1);
-      cache_entry->network_attrs = network_attrs | ICD_NW_ATTR_SRV_PROVIDER;
-      cache_entry->network_type = g_strdup(network_type);
-      cache_entry->signal = identify->signal;
-      cache_entry->network_id = g_strdup(network_id);
-      cache_entry->last_seen = time(NULL);
-      cache_entry->network_priority = icd_network_priority_get(service_type,
-                                                              service_id,
-                                                              network_type,
-                                                              network_attrs);
-      icd_scan_cache_entry_add(identify->module, scan_cache, cache_entry);
-    }
+    ILOG_DEBUG("srv provider created cache entry");
+    cache_entry = icd_scan_cache_entry_new();
+    cache_entry->network_attrs = network_attrs | ICD_NW_ATTR_SRV_PROVIDER;
+    cache_entry->network_type = (gchar *)icd_string_ref(network_type);
+    cache_entry->network_type_id = icd_scan_network_type_id(network_type);
+    cache_entry->signal = identify->signal;
+    cache_entry->network_id = (gchar *)icd_string_ref(network_id);
+    cache_entry->last_seen = time(NULL);
+    cache_entry->network_priority = icd_network_priority_get(service_type,
+                                                             service_id,
+                                                             network_type,
+                                                             network_attrs);
+    icd_scan_cache_entry_add(identify->module, cache_entry);
   }
 
   l = cache_entry->srv_provider_list;
@@ -666,9 +730,9 @@ create_entry:
   {
     provider = (struct icd_scan_srv_provider *)l->data;
 
-    if (provider && string_equal(provider->service_type, service_type) &&
+    if (provider && icd_string_equal(provider->service_type, service_type) &&
         provider->service_attrs == service_attrs &&
-        string_equal(provider->service_id, service_id))
+        icd_string_equal(provider->service_id, service_id))
     {
       break;
     }
@@ -688,6 +752,7 @@ create_entry:
 
       cache_entry->signal = identify->signal;
       provider->service_priority = service_priority;
+      icd_scan_cache_entry_changed(cache_entry);
 
       if (identify->signal > cache_entry->signal)
         status = ICD_SCAN_UPDATE;
@@ -699,18 +764,21 @@ create_entry:
   }
   else
   {
-    provider = g_new0(struct icd_scan_srv_provider, 1);
-    provider->service_type = g_strdup(service_type);
+    provider = icd_scan_srv_provider_new();
+    provider->service_type = (gchar *)icd_string_ref(service_type);
     provider->service_name = g_strdup(service_name);
     provider->service_attrs = service_attrs;
     provider->service_priority = service_priority;
-    provider->service_id = g_strdup(service_id);
+    provider->service_id = (gchar *)icd_string_ref(service_id);
     cache_entry->srv_provider_list =
         g_slist_prepend(cache_entry->srv_provider_list, provider);
+    icd_scan_cache_entry_changed(cache_entry);
     icd_scan_listener_notify(identify->module, provider, cache_entry,
                              ICD_SCAN_NEW);
   }
 
+  icd_srv_provider_identified(identify, cache_entry);
+
 out:
   if (!(status & ICD_SRV_CONTINUE))
     goto stop_identify;
@@ -718,7 +786,91 @@ out:
   return;
 
 stop_identify:
-    g_free(identify);
+  icd_srv_provider_identify_free(identify);
+}
+
+/**
+ * @brief Queue a network for the batched identify function of a service
+ * module; the strings are copied
+ *
+ * @param module the service module
+ * @param cache_entry the network
+ * @param status scan status of the network
+ * @param identify identification information to pass as the token
+ *
+ */
+static void
+icd_srv_provider_identify_queue(struct icd_srv_module *module,
+                                struct icd_scan_cache *cache_entry,
+                                enum icd_scan_status status,
+                                struct icd_srv_identify *identify)
+{
+  struct icd_srv_identify_request request;
+
+  if (!module->identify_pending)
+  {
+    module->identify_pending =
+        g_array_new(FALSE, FALSE, sizeof(struct icd_srv_identify_request));
+  }
+
+  request.status = status;
+  request.network_type = icd_string_ref(cache_entry->network_type);
+  request.network_name = g_strdup(cache_entry->network_name);
+  request.network_attrs = cache_entry->network_attrs;
+  request.network_id = icd_string_ref(cache_entry->network_id);
+  request.network_priority = cache_entry->network_priority;
+  request.signal = cache_entry->signal;
+  request.station_id = g_strdup(cache_entry->station_id);
+  request.dB = cache_entry->dB;
+  request.identify_cb_token = identify;
+
+  g_array_append_val(module->identify_pending, request);
+}
+
+/**
+ * @brief Give the queued networks to the batched identify functions of the
+ * service modules
+ *
+ */
+void
+icd_srv_provider_identify_flush(void)
+{
+  GSList *l;
+
+  for (l = icd_context_get()->srv_module_list; l; l = l->next)
+  {
+    struct icd_srv_module *module = (struct icd_srv_module *)l->data;
+    GArray *pending;
+    guint i;
+
+    if (!module || !module->identify_pending ||
+        !module->identify_pending->len)
+      continue;
+
+    /* the module may cause new identifications from the callback */
+    pending = module->identify_pending;
+    module->identify_pending = NULL;
+
+    ILOG_DEBUG("srv module '%s' identifying %u networks", module->name,
+               pending->len);
+
+    module->srv.identify_batch(
+          (const struct icd_srv_identify_request *)pending->data,
+          pending->len, icd_srv_provider_identify_cb, &module->srv.private);
+
+    for (i = 0; i < pending->len; i++)
+    {
+      struct icd_srv_identify_request *request =
+          &g_array_index(pending, struct icd_srv_identify_request, i);
+
+      icd_string_unref(request->network_type);
+      g_free((gchar *)request->network_name);
+      icd_string_unref(request->network_id);
+      g_free((gchar *)request->station_id);
+    }
+
+    g_array_free(pending, TRUE);
+  }
 }
 
 gboolean
@@ -726,24 +878,50 @@ icd_srv_provider_identify(struct icd_network_module *nw_module,
                           struct icd_scan_cache *cache_entry,
                           enum icd_scan_status status)
 {
+  struct icd_network_type *type;
   GSList *l;
   gboolean rv = FALSE;
 
-  l = (GSList *)g_hash_table_lookup(icd_context_get()->nw_type_to_srv_module,
-                                    cache_entry->network_type);
+  type = icd_network_api_type_get_by_id(cache_entry->network_type_id);
+
+  if (type)
+    l = type->srv_module_list;
+  else
+  {
+    l = (GSList *)g_hash_table_lookup(
+          icd_context_get()->nw_type_to_srv_module, cache_entry->network_type);
+  }
 
   for (; l; l = l->next)
   {
     struct icd_srv_module *module = (struct icd_srv_module *)l->data;
     if (module)
     {
-      if (module->srv.identify)
+      if (module->srv.identify &&
+          !g_slist_find(cache_entry->srv_identified_list, module))
       {
-        struct icd_srv_identify *identify = g_new0(struct icd_srv_identify, 1);
+        struct icd_srv_identify *identify =
+            g_slice_new0(struct icd_srv_identify);
+        struct icd_scan_alloc_stats *stats = icd_scan_alloc_stats_get();
+
+        stats->identifies++;
+        stats->identifies_total++;
 
         rv = TRUE;
         identify->module = nw_module;
         identify->signal = cache_entry->signal;
+        identify->srv_module = module;
+        identify->network_type = icd_string_ref(cache_entry->network_type);
+        identify->network_attrs = cache_entry->network_attrs;
+        identify->network_id = icd_string_ref(cache_entry->network_id);
+
+        if (module->srv.identify_batch)
+        {
+          icd_srv_provider_identify_queue(module, cache_entry, status,
+                                          identify);
+          continue;
+        }
+
         module->srv.identify(status, cache_entry->network_type,
                              cache_entry->network_name,
                              cache_entry->network_attrs,
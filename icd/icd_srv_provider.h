@@ -16,6 +16,9 @@ struct icd_srv_module {
   GSList *pid_list;
   struct icd_srv_api srv;
 
+  /** #icd_srv_identify_request array waiting for
+   *  #icd_srv_provider_identify_flush */
+  GArray *identify_pending;
 };
 
 typedef gboolean
@@ -48,6 +51,8 @@ gboolean icd_srv_provider_identify (struct icd_network_module *nw_module,
                                     struct icd_scan_cache *cache_entry,
                                     enum icd_scan_status status);
 
+void icd_srv_provider_identify_flush (void);
+
 gboolean icd_srv_provider_notify_pid (struct icd_context *icd_ctx,
                                       const pid_t pid,
                                       const gint exit_value);
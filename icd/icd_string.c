@@ -0,0 +1,140 @@
+#include <string.h>
+
+#include "icd_log.h"
+#include "icd_string.h"
+
+/**
+ * @brief Get the table of interned strings
+ *
+ * @return the hash table containing the interned strings as keys and their
+ * reference counts as values
+ *
+ */
+static GHashTable *
+icd_string_table_get(void)
+{
+  static GHashTable *string_table = NULL;
+
+  if (!string_table)
+    string_table = g_hash_table_new(g_str_hash, g_str_equal);
+
+  return string_table;
+}
+
+/**
+ * @brief Get a reference to the interned copy of a string; equal strings
+ * interned this way share the same pointer and can be compared as pointers
+ *
+ * @param string the string to intern or NULL
+ *
+ * @return the interned string, to be released with #icd_string_unref; NULL if
+ * string is NULL
+ *
+ */
+const gchar *
+icd_string_ref(const gchar *string)
+{
+  GHashTable *string_table;
+  gpointer interned, refcount;
+
+  if (!string)
+    return NULL;
+
+  string_table = icd_string_table_get();
+
+  if (g_hash_table_lookup_extended(string_table, string, &interned, &refcount))
+  {
+    g_hash_table_insert(string_table, interned,
+                        GUINT_TO_POINTER(GPOINTER_TO_UINT(refcount) + 1));
+  }
+  else
+  {
+    interned = g_strdup(string);
+    g_hash_table_insert(string_table, interned, GUINT_TO_POINTER(1));
+  }
+
+  return (const gchar *)interned;
+}
+
+/**
+ * @brief Find the interned copy of a string without taking a reference
+ *
+ * @param string the string to look up or NULL
+ *
+ * @return the interned string or NULL if the string is not interned
+ *
+ */
+const gchar *
+icd_string_lookup(const gchar *string)
+{
+  gpointer interned;
+
+  if (!string ||
+      !g_hash_table_lookup_extended(icd_string_table_get(), string, &interned,
+                                    NULL))
+  {
+    return NULL;
+  }
+
+  return (const gchar *)interned;
+}
+
+/**
+ * @brief Release a reference to an interned string; the string is freed when
+ * the last reference is released
+ *
+ * @param string the interned string as returned by #icd_string_ref or NULL
+ *
+ */
+void
+icd_string_unref(const gchar *string)
+{
+  GHashTable *string_table;
+  gpointer interned, refcount;
+  guint count;
+
+  if (!string)
+    return;
+
+  string_table = icd_string_table_get();
+
+  if (!g_hash_table_lookup_extended(string_table, string, &interned,
+                                    &refcount) ||
+      interned != string)
+  {
+    ILOG_ERR("string '%s' is not interned", string);
+    return;
+  }
+
+  count = GPOINTER_TO_UINT(refcount) - 1;
+
+  if (count)
+    g_hash_table_insert(string_table, interned, GUINT_TO_POINTER(count));
+  else
+  {
+    g_hash_table_remove(string_table, interned);
+    g_free(interned);
+  }
+}
+
+/**
+ * @brief Helper function for comparing two strings where a NULL string is equal
+ * to another NULL string
+ *
+ * @param a string A
+ * @param b string B
+ *
+ * @return TRUE if equal, FALSE if unequal
+ *
+ */
+gboolean
+icd_string_equal(const gchar *a, const gchar *b)
+{
+  if (!a)
+    return !b;
+
+  if (b)
+    return !strcmp(a, b);
+
+  return FALSE;
+}
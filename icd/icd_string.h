@@ -0,0 +1,14 @@
+#ifndef ICD_STRING_H
+#define ICD_STRING_H
+
+#include <glib.h>
+
+const gchar *icd_string_ref (const gchar *string);
+
+const gchar *icd_string_lookup (const gchar *string);
+
+void icd_string_unref (const gchar *string);
+
+gboolean icd_string_equal (const gchar *a, const gchar *b);
+
+#endif
@@ -67,7 +67,8 @@ icd_tracking_info_foreach(struct icd_request *request, gpointer user_data)
   {
     struct icd_tracking_info *track = (struct icd_tracking_info *)l->data;
 
-    if (strcmp((const char *)user_data, track->sender))
+    if (track && track->sender && !strcmp((const char *)user_data,
+                                          track->sender))
       return track;
 
   }
@@ -87,7 +88,8 @@ struct icd_tracking_info *
 icd_tracking_info_find(const gchar *sender)
 {
   return (struct icd_tracking_info *)
-      icd_request_foreach(icd_tracking_info_foreach, (gpointer)sender);
+      icd_request_foreach_sender(sender, icd_tracking_info_foreach,
+                                 (gpointer)sender);
 }
 
 /**
@@ -130,6 +130,10 @@ enum icd_nw_levels {
 /** Whether we have all required credentials to authenticate ourselves to the
  * network automatically without any user interaction */
 #define ICD_NW_ATTR_AUTOCONNECT    0x04000000
+/** Set by ICd2 in scan results of networks restored from the scan cache
+ * snapshot at startup and not seen by a scan since; never set by network
+ * modules */
+#define ICD_NW_ATTR_STALE          0x08000000
 /** Whether this network always needs service provider support in order to get
  * connected */
 #define ICD_NW_ATTR_SRV_PROVIDER   0x10000000
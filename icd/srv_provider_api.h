@@ -158,6 +158,44 @@ typedef void (*icd_srv_identify_fn) (enum icd_scan_status status,
 				     gpointer identify_cb_token,
 				     gpointer *private);
 
+/** One network in a batch given to #icd_srv_identify_batch_fn; the strings
+ * are valid only during the call */
+struct icd_srv_identify_request {
+  /** status, see #icd_scan_status */
+  enum icd_scan_status status;
+  /** network type */
+  const gchar *network_type;
+  /** name of the network displayable to the user */
+  const gchar *network_name;
+  /** network attributes */
+  guint network_attrs;
+  /** network identification */
+  const gchar *network_id;
+  /** network priority */
+  guint network_priority;
+  /** signal strength */
+  enum icd_nw_levels signal;
+  /** station id, e.g. MAC address or similar id */
+  const gchar *station_id;
+  /** absolute signal strength value in dB */
+  gint dB;
+  /** token to pass to the identification callback for this network */
+  gpointer identify_cb_token;
+};
+
+/** Identify a batch of networks; the same as calling #icd_srv_identify_fn for
+ * each of them, the identification callback is called with the token of
+ * each network. Optional, requires #ICD_SRV_MODULE_VERSION 0.89 or later.
+ * @param requests array of networks to identify
+ * @param count number of networks in the array
+ * @param identify_cb callback to call when an identification has been done
+ * @param private a reference to the icd_srv_api private member
+ */
+typedef void (*icd_srv_identify_batch_fn) (const struct icd_srv_identify_request *requests,
+					   guint count,
+					   icd_srv_identify_cb_fn identify_cb,
+					   gpointer *private);
+
 /** Disconnect callback for the service provider module
  * @param status status of the disconnect, ignored for now
  * @param disconnect_cb_token token passed to the disconnect function
@@ -261,6 +299,9 @@ struct icd_srv_api {
 
   /** cleanup function */
   icd_srv_destruct_fn srv_destruct;
+
+  /** batched network identification function, optional */
+  icd_srv_identify_batch_fn identify_batch;
 };
 
 